@@ -0,0 +1,250 @@
+
+#ifndef NTL_BasicThreadPool__H
+#define NTL_BasicThreadPool__H
+
+#include <NTL/tools.h>
+#include <NTL/thread.h>
+#include <NTL/SmartPtr.h>
+
+#ifdef NTL_THREADS
+
+#include <atomic>
+#include <functional>
+#include <exception>
+
+#endif
+
+
+NTL_OPEN_NNS
+
+/************************************************************************
+
+A BasicThreadPool runs work on a fixed set of threads.  NumThreads()
+counts the calling thread, which always takes part in the work, so a
+pool of 1 thread runs everything on the caller.
+
+Each worker thread has its own queue of tasks.  A worker takes tasks
+from the back of its own queue and, when that is empty, steals from the
+front of the other queues; a thread waiting on a TaskGroup does the same,
+so nested parallel regions never block a worker.
+
+   pool.exec_range(sz, fct);
+   pool.exec_range(sz, grain, fct);
+
+      Partitions [0, sz) into ranges of at least grain (default 1)
+      indices and calls fct(first, last) for each range, in parallel;
+      returns when all calls have returned.
+
+   pool.exec_index(cnt, fct);
+
+      Calls fct(index) for index in [0, cnt), in parallel.
+
+   BasicThreadPool::TaskGroup group(&pool);
+   group.run(fct);  ...  group.wait();
+
+      run queues the call fct() on the pool; wait returns when every
+      call queued on the group has returned (the destructor also waits).
+      If a call throws, wait rethrows the first exception.
+
+The process-wide pool returned by GetThreadPool() is created on first
+use with AvailableThreads() threads (the number of hardware threads);
+SetNumThreads(n) replaces it, and must not be called while it is in use.
+
+The macros
+
+   NTL_EXEC_RANGE(sz, first, last)
+      ... body using first, last ...
+   NTL_EXEC_RANGE_END
+
+   NTL_GEXEC_RANGE(seq, sz, first, last) ... NTL_EXEC_RANGE_END
+
+run the body over a partition of [0, sz) on the process-wide pool
+(NTL_GEXEC_RANGE runs it as a single range on the caller when seq is
+true).  Without NTL_THREADS, all of the above run sequentially on the
+caller.
+
+************************************************************************/
+
+
+#ifdef NTL_THREADS
+
+
+class BasicThreadPool {
+public:
+   class TaskGroup;
+
+private:
+   class Rep;
+   UniquePtr<Rep> rep;
+   long nthreads;
+
+   BasicThreadPool(const BasicThreadPool&); // disabled
+   void operator=(const BasicThreadPool&); // disabled
+
+   void submit(TaskGroup *group, const NTL_SNS function<void()>& fct);
+   void execute(TaskGroup *group, const NTL_SNS function<void()>& fct);
+   void help(TaskGroup *group);
+   void worker(long index);
+
+public:
+   explicit BasicThreadPool(long n);
+   ~BasicThreadPool();
+
+   long NumThreads() const { return nthreads; }
+
+   class TaskGroup {
+   private:
+      BasicThreadPool *pool;
+      NTL_SNS atomic_long pending;
+      MutexProxy mtx;   // guards eptr
+      NTL_SNS exception_ptr eptr;
+
+      TaskGroup(const TaskGroup&); // disabled
+      void operator=(const TaskGroup&); // disabled
+
+      friend class BasicThreadPool;
+
+   public:
+      explicit TaskGroup(BasicThreadPool *_pool) : pool(_pool), pending(0) { }
+      ~TaskGroup();
+
+      template<class Fct>
+      void run(const Fct& fct) { pool->submit(this, fct); }
+
+      void wait();
+   };
+
+   template<class Fct>
+   void exec_range(long sz, long grain, const Fct& fct)
+   {
+      if (sz <= 0) return;
+      if (grain < 1) grain = 1;
+
+      // a few ranges per thread, so that stealing can even out the load
+      long nranges = min(4*nthreads, (sz + grain - 1)/grain);
+      if (nranges <= 1) {
+         fct(0, sz);
+         return;
+      }
+
+      TaskGroup group(this);
+      long q = sz/nranges, r = sz%nranges;
+      long first = 0;
+      for (long i = 0; i < nranges; i++) {
+         long last = first + q + (i < r);
+         if (i == nranges-1)
+            fct(first, last);
+         else
+            group.run([&fct, first, last]() { fct(first, last); });
+         first = last;
+      }
+      group.wait();
+   }
+
+   template<class Fct>
+   void exec_range(long sz, const Fct& fct) { exec_range(sz, 1, fct); }
+
+   template<class Fct>
+   void exec_index(long cnt, const Fct& fct)
+   {
+      exec_range(cnt, 1,
+         [&fct](long first, long last) {
+            for (long i = first; i < last; i++) fct(i);
+         });
+   }
+};
+
+
+#define NTL_EXEC_RANGE(sz, first, last) \
+{ \
+   NTL_NNS GetThreadPool()->exec_range((sz), [&](long first, long last) { \
+
+
+#define NTL_GEXEC_RANGE(seq, sz, first, last) \
+{ \
+   NTL_NNS GetThreadPool()->exec_range((seq) ? 1 : (sz), \
+   [&](long first, long last) { \
+   if (seq) { first = 0; last = (sz); } \
+
+
+#define NTL_EXEC_RANGE_END \
+   } ); \
+} \
+
+
+#else
+
+
+class BasicThreadPool {
+private:
+   BasicThreadPool(const BasicThreadPool&); // disabled
+   void operator=(const BasicThreadPool&); // disabled
+
+public:
+   explicit BasicThreadPool(long n) { }
+
+   long NumThreads() const { return 1; }
+
+   class TaskGroup {
+   private:
+      TaskGroup(const TaskGroup&); // disabled
+      void operator=(const TaskGroup&); // disabled
+
+   public:
+      explicit TaskGroup(BasicThreadPool *pool) { }
+
+      template<class Fct>
+      void run(const Fct& fct) { fct(); }
+
+      void wait() { }
+   };
+
+   template<class Fct>
+   void exec_range(long sz, long grain, const Fct& fct)
+   {
+      if (sz > 0) fct(0, sz);
+   }
+
+   template<class Fct>
+   void exec_range(long sz, const Fct& fct) { exec_range(sz, 1, fct); }
+
+   template<class Fct>
+   void exec_index(long cnt, const Fct& fct)
+   {
+      for (long i = 0; i < cnt; i++) fct(i);
+   }
+};
+
+
+#define NTL_EXEC_RANGE(sz, first, last) \
+{ \
+   long first = 0; \
+   long last = (sz); \
+   { \
+
+
+#define NTL_GEXEC_RANGE(seq, sz, first, last) \
+{ \
+   long first = 0; \
+   long last = (sz); \
+   { \
+
+
+#define NTL_EXEC_RANGE_END \
+   } \
+} \
+
+
+#endif
+
+
+long AvailableThreads();
+
+BasicThreadPool *GetThreadPool();
+
+void SetNumThreads(long n);
+
+
+NTL_CLOSE_NNS
+
+#endif
@@ -155,6 +155,36 @@ public:
 #define NTL_ZZRegister(x) NTL_THREAD_LOCAL static ZZ x; ZZWatcher _WATCHER__ ## x(x)
 
 
+#ifndef NTL_GMP_LIP
+
+// only defined for the "classic" long integer package
+
+class ZZArenaPush {
+// While a ZZArenaPush is alive, new ZZ storage of the calling thread
+// comes from the thread's arena (see _ntl_zarena in c_lip.h).
+// When the outermost one is destroyed, the arena is reset, so each
+// scoped operation reuses the memory of the previous one.
+
+private:
+const _ntl_zallocator *old;
+
+ZZArenaPush(const ZZArenaPush&); // disabled
+void operator=(const ZZArenaPush&); // disabled
+
+public:
+ZZArenaPush() { const _ntl_zallocator *a = _ntl_zarena(); old = _ntl_zset_allocator(a); }
+
+~ZZArenaPush()
+{
+   const _ntl_zallocator *a = _ntl_zset_allocator(old);
+   if (old != a) _ntl_zarena_reset();
+}
+
+};
+
+#endif
+
+
 
 
 
@@ -552,6 +582,36 @@ public:
 };
 
 
+// Special routines for repeated reduction by a fixed modulus p > 1.
+// For odd p, and when excess <= p*R, eval performs Montgomery
+// reduction with R = 2^(NTL_ZZ_NBITS*k), k = the number of digits 
+// of p; otherwise R = 1 and eval is an ordinary remainder.
+// Values kept in the form x*R mod p can be multiplied with a mul
+// and an eval, with no division by p.
+
+class ZZ_ReduceStructAdapter {
+public:
+   UniquePtr<_ntl_reduce_struct> rep;
+
+   void init(const ZZ& p, const ZZ& excess)
+   {
+      rep.reset(_ntl_reduce_struct_build(p.rep, excess.rep));
+   }
+
+   void eval(ZZ& x, ZZ& a) const
+   // x = a/R mod p, for 0 <= a < excess; x and a may alias
+   {
+      rep->eval(&x.rep, &a.rep);
+   }
+
+   void adjust(ZZ& x) const
+   // x = x*R mod p, for 0 <= x < p
+   {
+      rep->adjust(&x.rep);
+   }
+};
+
+
 inline void ZZ_TmpVecAdapter::fetch(const ZZ_CRTStructAdapter& crt_struct)
 {
    rep.reset(crt_struct.rep->fetch());
@@ -1234,6 +1294,36 @@ inline ZZ PowerMod(const ZZ& a, long e, const ZZ& n)
    { ZZ x; PowerMod(x, a, e, n); NTL_OPT_RETURN(ZZ, x); }
 
 
+// Special routines for repeated exponentiation by a fixed exponent
+// e >= 0 modulo a fixed modulus n > 1 (e.g., Fermat inversion, 
+// square roots and Legendre symbols mod a fixed prime).
+// init chooses the sliding window size that minimizes the number of
+// multiplications for e and records the window schedule; eval runs 
+// that schedule with a ZZ_ReduceStructAdapter for n (Montgomery 
+// reduction for odd n), with no per-call recoding of e.
+
+class ZZ_PowerModStruct {
+public:
+   ZZ_ReduceStructAdapter red;
+   ZZ n;
+   Vec<long> sq;   // squarings before each window multiplication
+   Vec<long> win;  // odd window values, most significant first
+   long tail;      // squarings after the last window
+   long tab;       // number of odd powers g, g^3, ... used by win
+
+   ZZ_PowerModStruct() : tail(0), tab(0) { }
+
+   void init(const ZZ& e, const ZZ& n);
+
+   void eval(ZZ& x, const ZZ& a) const;
+   // x = a^e mod n, for 0 <= a < n
+
+private:
+   ZZ_PowerModStruct(const ZZ_PowerModStruct&); // disabled
+   void operator=(const ZZ_PowerModStruct&); // disabled
+};
+
+
 
 
 
@@ -435,7 +435,8 @@ typedef long _ntl_verylong_body;
 
     Storage Allocation
 
-    These routines use malloc and free.
+    These routines use malloc and free, unless another allocator
+    has been installed with _ntl_zset_allocator.
 
 ***********************************************************************/
 
@@ -454,6 +455,30 @@ typedef long _ntl_verylong_body;
        /* Free's space held by x, and sets x back to 0. */
 
 
+    struct _ntl_zallocator {
+       void *(*alloc)(void *ctx, long n);
+       void (*free)(void *ctx, void *p);
+       void *ctx;
+    };
+       /* Source of bigint storage: alloc returns n bytes aligned
+          for a long, or 0 on failure; free gets back a pointer
+          returned by alloc, possibly from another thread. */
+
+    const _ntl_zallocator *_ntl_zset_allocator(const _ntl_zallocator *a);
+       /* Makes a the allocator for all new storage of the calling
+          thread (0 selects malloc) and returns the previous one.
+          Storage is always given back to the allocator it came from. */
+
+    const _ntl_zallocator *_ntl_zarena(void);
+       /* The calling thread's arena: a pool of size classes cut
+          from large chunks, with no locking on the owning thread. */
+
+    void _ntl_zarena_reset(void);
+       /* Recycles the arena of the calling thread: if none of its
+          blocks is still in use, all its memory but one chunk is 
+          released and allocation starts over. */
+
+
 /*******************************************************************
 
     Special routines
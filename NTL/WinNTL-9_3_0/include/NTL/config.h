@@ -83,7 +83,7 @@ using the configure script.
 
 #endif
 
-#if 0
+#if 1
 #define NTL_THREADS
 
 /* Set if you want to compile NTL as a thread-safe library.
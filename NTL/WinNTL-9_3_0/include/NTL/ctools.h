@@ -295,6 +295,26 @@ extern unsigned long exception_counter;
  */
 
 
+#ifndef NTL_ZZ_SMALL_LIMBS
+#define NTL_ZZ_SMALL_LIMBS (8)
+#endif
+
+/*
+ * bigints with room for at most this many digits are recycled through
+ * a per-thread cache of freed blocks instead of malloc/free
+ * (see c_lip_impl.h); 0 disables the cache.
+ */
+
+
+#ifndef NTL_ZZ_SMALL_CACHE
+#define NTL_ZZ_SMALL_CACHE (64)
+#endif
+
+/*
+ * maximum number of cached blocks per block size and thread.
+ */
+
+
 
 long _ntl_IsFinite(double *p);
 /* This forces a double into memory, and tests if it is "normal";
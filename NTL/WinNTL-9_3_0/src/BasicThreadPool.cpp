@@ -0,0 +1,294 @@
+
+#include <NTL/BasicThreadPool.h>
+
+#ifdef NTL_THREADS
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+
+#endif
+
+
+NTL_START_IMPL
+
+
+#ifdef NTL_THREADS
+
+
+struct PoolTask {
+   BasicThreadPool::TaskGroup *group;
+   function<void()> fct;
+};
+
+struct PoolQueue {
+   mutex mtx;
+   deque<PoolTask> tasks;
+};
+
+
+class BasicThreadPool::Rep {
+public:
+   vector< unique_ptr<PoolQueue> > queues;   // one per worker, at least one
+   vector<thread> threads;
+
+   mutex mtx;               // guards sleeping, and the increments of queued
+   condition_variable cv;
+   atomic_long queued;      // tasks sitting in the queues
+   atomic_ulong next;       // queue for tasks submitted from outside
+   bool stop;
+
+   Rep() : queued(0), next(0), stop(false) { }
+
+   bool take(long index, PoolTask& task);
+};
+
+
+// the pool (if any) that the current thread works for, and its queue
+
+NTL_THREAD_LOCAL static BasicThreadPool *CurrentPool = 0;
+NTL_THREAD_LOCAL static long CurrentIndex = -1;
+
+
+bool BasicThreadPool::Rep::take(long index, PoolTask& task)
+// own queue from the back (most recent, still warm in cache),
+// then the other queues from the front
+
+{
+   long nq = queues.size();
+
+   if (index >= 0) {
+      PoolQueue& q = *queues[index];
+      lock_guard<mutex> lck(q.mtx);
+      if (!q.tasks.empty()) {
+         task = move(q.tasks.back());
+         q.tasks.pop_back();
+         queued--;
+         return true;
+      }
+   }
+
+   long start = index >= 0 ? index+1 : 0;
+
+   for (long j = 0; j < nq; j++) {
+      long i = (start + j) % nq;
+      if (i == index) continue;
+      PoolQueue& q = *queues[i];
+      lock_guard<mutex> lck(q.mtx);
+      if (!q.tasks.empty()) {
+         task = move(q.tasks.front());
+         q.tasks.pop_front();
+         queued--;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+
+BasicThreadPool::BasicThreadPool(long n) : nthreads(n)
+{
+   if (n <= 0) LogicError("BasicThreadPool: bad args");
+
+   rep.make();
+
+   long nw = n-1;
+   long nq = max(nw, 1L);
+
+   for (long i = 0; i < nq; i++)
+      rep->queues.push_back(unique_ptr<PoolQueue>(new PoolQueue));
+
+   for (long i = 0; i < nw; i++)
+      rep->threads.push_back(thread(&BasicThreadPool::worker, this, i));
+}
+
+
+BasicThreadPool::~BasicThreadPool()
+{
+   {
+      lock_guard<mutex> lck(rep->mtx);
+      rep->stop = true;
+   }
+   rep->cv.notify_all();
+
+   for (long i = 0; i < long(rep->threads.size()); i++)
+      rep->threads[i].join();
+}
+
+
+void BasicThreadPool::submit(TaskGroup *group, const function<void()>& fct)
+{
+   Rep& r = *rep;
+
+   group->pending++;
+
+   long i;
+   if (CurrentPool == this) 
+      i = CurrentIndex;
+   else
+      i = r.next.fetch_add(1, memory_order_relaxed) % r.queues.size();
+
+   {
+      PoolQueue& q = *r.queues[i];
+      lock_guard<mutex> lck(q.mtx);
+      PoolTask task;
+      task.group = group;
+      task.fct = fct;
+      q.tasks.push_back(move(task));
+   }
+
+   {
+      lock_guard<mutex> lck(r.mtx);
+      r.queued++;
+   }
+   r.cv.notify_one();
+}
+
+
+void BasicThreadPool::execute(TaskGroup *group, const function<void()>& fct)
+{
+   try {
+      fct();
+   }
+   catch (...) {
+      GuardProxy guard(group->mtx);
+      guard.lock();
+      if (!group->eptr) group->eptr = current_exception();
+   }
+
+   // group may be destroyed as soon as pending drops to 0
+
+   if (--group->pending == 0) {
+      lock_guard<mutex> lck(rep->mtx);
+      rep->cv.notify_all();
+   }
+}
+
+
+void BasicThreadPool::help(TaskGroup *group)
+{
+   Rep& r = *rep;
+   long index = (CurrentPool == this) ? CurrentIndex : -1;
+
+   while (group->pending > 0) {
+      PoolTask task;
+      if (r.take(index, task)) {
+         execute(task.group, task.fct);
+         continue;
+      }
+
+      unique_lock<mutex> lck(r.mtx);
+      r.cv.wait(lck, [&]() { return group->pending == 0 || r.queued > 0; });
+   }
+}
+
+
+void BasicThreadPool::worker(long index)
+{
+   Rep& r = *rep;
+
+   CurrentPool = this;
+   CurrentIndex = index;
+
+   for (;;) {
+      PoolTask task;
+      if (r.take(index, task)) {
+         execute(task.group, task.fct);
+         continue;
+      }
+
+      unique_lock<mutex> lck(r.mtx);
+      r.cv.wait(lck, [&]() { return r.stop || r.queued > 0; });
+      if (r.stop && r.queued == 0) break;
+   }
+
+   CurrentPool = 0;
+   CurrentIndex = -1;
+}
+
+
+BasicThreadPool::TaskGroup::~TaskGroup()
+{
+   pool->help(this);
+}
+
+
+void BasicThreadPool::TaskGroup::wait()
+{
+   pool->help(this);
+
+   if (eptr) {
+      exception_ptr e = eptr;
+      eptr = nullptr;
+      rethrow_exception(e);
+   }
+}
+
+
+long AvailableThreads()
+{
+   long n = thread::hardware_concurrency();
+   return n > 0 ? n : 1;
+}
+
+
+static mutex GlobalPoolMutex;
+static unique_ptr<BasicThreadPool> GlobalPoolOwner;
+static atomic<BasicThreadPool *> GlobalPool(0);
+
+
+BasicThreadPool *GetThreadPool()
+{
+   BasicThreadPool *pool = GlobalPool.load(memory_order_acquire);
+   if (pool) return pool;
+
+   lock_guard<mutex> lck(GlobalPoolMutex);
+   if (!GlobalPoolOwner) {
+      GlobalPoolOwner.reset(new BasicThreadPool(AvailableThreads()));
+      GlobalPool.store(GlobalPoolOwner.get(), memory_order_release);
+   }
+   return GlobalPoolOwner.get();
+}
+
+
+void SetNumThreads(long n)
+{
+   unique_ptr<BasicThreadPool> pool(new BasicThreadPool(n));
+
+   lock_guard<mutex> lck(GlobalPoolMutex);
+   GlobalPool.store(pool.get(), memory_order_release);
+   GlobalPoolOwner.swap(pool);
+   // the old pool (if any) is shut down here
+}
+
+
+#else
+
+
+long AvailableThreads()
+{
+   return 1;
+}
+
+
+BasicThreadPool *GetThreadPool()
+{
+   static BasicThreadPool pool(1);
+   return &pool;
+}
+
+
+void SetNumThreads(long n)
+{
+   if (n <= 0) LogicError("SetNumThreads: bad args");
+}
+
+
+#endif
+
+
+NTL_END_IMPL
@@ -739,6 +739,136 @@ void PowerMod(ZZ& x, const ZZ& a, const ZZ& e, const ZZ& n)
    else
       LowLevelPowerMod(x, a, e, n); 
 }
+
+
+static
+long PowerModRecode(Vec<long>& sq, Vec<long>& win, long& tail, 
+                    const ZZ& e, long k)
+// sliding window recoding of e > 0 with windows of at most k bits;
+// returns the number of odd powers needed
+
+{
+   long i, j, pending, val, maxval;
+
+   sq.SetLength(0);
+   win.SetLength(0);
+   pending = 0;
+   maxval = 1;
+
+   i = NumBits(e) - 1;
+   while (i >= 0) {
+      if (!bit(e, i)) {
+         pending++;
+         i--;
+         continue;
+      }
+
+      j = i - k + 1;
+      if (j < 0) j = 0;
+      while (!bit(e, j)) j++;
+
+      val = 0;
+      for (long l = i; l >= j; l--)
+         val = (val << 1) | bit(e, l);
+
+      pending += i - j + 1;
+      sq.append(pending);
+      win.append(val);
+      if (val > maxval) maxval = val;
+
+      pending = 0;
+      i = j - 1;
+   }
+
+   tail = pending;
+   return (maxval >> 1) + 1;
+}
+
+
+void ZZ_PowerModStruct::init(const ZZ& e, const ZZ& nn)
+{
+   if (e < 0 || nn <= 1)
+      LogicError("ZZ_PowerModStruct: bad args");
+
+   n = nn;
+   red.init(n, sqr(n));
+
+   if (IsZero(e)) {
+      sq.SetLength(0);
+      win.SetLength(0);
+      tail = 0;
+      tab = 0;
+      return;
+   }
+
+   // cost = multiplications outside the squaring chain: windows after
+   // the first, the odd powers, and g^2 when more than one is needed
+
+   long best_cost = -1;
+
+   for (long k = 1; k <= 6; k++) {
+      Vec<long> sq1, win1;
+      long tail1;
+      long tab1 = PowerModRecode(sq1, win1, tail1, e, k);
+      long cost = win1.length() - 1 + tab1 - 1 + (tab1 > 1);
+
+      if (best_cost < 0 || cost < best_cost) {
+         best_cost = cost;
+         sq.swap(sq1);
+         win.swap(win1);
+         tail = tail1;
+         tab = tab1;
+      }
+   }
+}
+
+
+void ZZ_PowerModStruct::eval(ZZ& x, const ZZ& a) const
+{
+   if (a < 0 || a >= n)
+      LogicError("ZZ_PowerModStruct: bad args");
+
+   if (win.length() == 0) {
+      set(x);
+      return;
+   }
+
+   Vec<ZZ> T;
+   NTL_ZZRegister(t);
+   NTL_ZZRegister(res);
+   long i, j;
+
+   T.SetLength(tab);
+   T[0] = a;
+   red.adjust(T[0]);
+
+   if (tab > 1) {
+      sqr(t, T[0]);
+      red.eval(t, t);
+      for (i = 1; i < tab; i++) {
+         mul(T[i], T[i-1], t);
+         red.eval(T[i], T[i]);
+      }
+   }
+
+   res = T[win[0] >> 1];
+
+   for (i = 1; i < win.length(); i++) {
+      for (j = 0; j < sq[i]; j++) {
+         sqr(res, res);
+         red.eval(res, res);
+      }
+      mul(res, res, T[win[i] >> 1]);
+      red.eval(res, res);
+   }
+
+   for (j = 0; j < tail; j++) {
+      sqr(res, res);
+      red.eval(res, res);
+   }
+
+   red.eval(x, res);
+}
    
 #ifdef NTL_EXCEPTIONS
 
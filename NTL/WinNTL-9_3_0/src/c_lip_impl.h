@@ -4,6 +4,10 @@
 #include <NTL/vector.h>
 #include <NTL/SmartPtr.h>
 
+#ifdef NTL_THREADS
+#include <atomic>
+#endif
+
 NTL_CLIENT
 
 
@@ -1410,6 +1414,398 @@ long _ntl_zmaxalloc(_ntl_verylong x)
 }
       
 
+/*
+ * Block layout.
+ *
+ * Every block obtained by _ntl_zsetlength starts with one word naming
+ * the allocator that owns it (0 for malloc), followed by the usual
+ * header word (allocated length << 1) and the size word; the
+ * _ntl_verylong points at the size word.  Blocks made by
+ * _ntl_zblock_construct_alloc have no owner word; they are recognized
+ * by the low bit of the header and never reach the allocator.
+ */
+
+static inline const _ntl_zallocator *_ntl_zowner(long *raw)
+{
+   return *((const _ntl_zallocator **) raw);
+}
+
+
+/*
+ * Small-block cache.
+ *
+ * A ZZ cannot keep its digits inline: NTL vectors move their elements
+ * with realloc, so a ZZ must remain valid after a bitwise copy.
+ * Instead, freed malloc blocks with room for at most NTL_ZZ_SMALL_LIMBS
+ * digits are kept on per-thread free lists, one list per block size (a
+ * multiple of MIN_SETL), and _ntl_zsetlength hands them out again.
+ * Once the lists are warm, the temporaries of ordinary arithmetic on
+ * numbers of that size never reach malloc/free.  Each cached block is
+ * an ordinary malloc block, so a block freed by a thread other than its
+ * allocator is simply cached by the freeing thread.
+ */
+
+#if (NTL_ZZ_SMALL_LIMBS > 0)
+
+#define SMALL_SETL (((NTL_ZZ_SMALL_LIMBS+1+(MIN_SETL-1))/MIN_SETL)*MIN_SETL)
+#define SMALL_CLASSES (SMALL_SETL/MIN_SETL)
+
+struct _ntl_zcache_lists {
+   long *head[SMALL_CLASSES];
+   long count[SMALL_CLASSES];
+   long armed;
+   long dead;
+};
+
+// trivially destructible, so it stays usable while static objects
+// holding bigints are destroyed after the thread's cache has been drained
+NTL_THREAD_LOCAL static _ntl_zcache_lists _ntl_zcache;
+
+class _ntl_zcache_guard {
+public:
+   long used;
+
+   ~_ntl_zcache_guard()
+   {
+      _ntl_zcache_lists& c = _ntl_zcache;
+      for (long i = 0; i < SMALL_CLASSES; i++) {
+         while (c.head[i]) {
+            long *p = c.head[i];
+            c.head[i] = *((long **) p);
+            free((void*)p);
+         }
+         c.count[i] = 0;
+      }
+      c.dead = 1;
+   }
+};
+
+NTL_THREAD_LOCAL static _ntl_zcache_guard _ntl_zcache_drain;
+
+static inline long _ntl_zcache_avail(long len)
+{
+   return len <= SMALL_SETL && _ntl_zcache.head[len/MIN_SETL - 1] != 0;
+}
+
+/* block of len digits (len a multiple of MIN_SETL) from the cache, or 0 */
+static inline long *_ntl_zcache_get(long len)
+{
+   if (len > SMALL_SETL) return 0;
+   _ntl_zcache_lists& c = _ntl_zcache;
+   long i = len/MIN_SETL - 1;
+   long *p = c.head[i];
+   if (p) {
+      c.head[i] = *((long **) p);
+      c.count[i]--;
+   }
+   return p;
+}
+
+/* keep the malloc block p (p[1] is its header) for reuse; 0 if not cached */
+static inline long _ntl_zcache_put(long *p)
+{
+   long len = p[1] >> 1;
+   if (len > SMALL_SETL) return 0;
+   _ntl_zcache_lists& c = _ntl_zcache;
+   long i = len/MIN_SETL - 1;
+   if (c.dead || c.count[i] >= NTL_ZZ_SMALL_CACHE) return 0;
+   if (!c.armed) {
+      // registers the drain at thread exit
+      _ntl_zcache_drain.used = 1;
+      c.armed = 1;
+   }
+   *((long **) p) = c.head[i];
+   c.head[i] = p;
+   c.count[i]++;
+   return 1;
+}
+
+#else
+
+static inline long _ntl_zcache_avail(long len) { return 0; }
+static inline long *_ntl_zcache_get(long len) { return 0; }
+static inline long _ntl_zcache_put(long *p) { return 0; }
+
+#endif
+
+
+/*
+ * Allocator hook.
+ *
+ * _ntl_zset_allocator installs, for the calling thread, the allocator
+ * used for all new bigint storage.  A block is always returned to the
+ * allocator that made it, whichever allocator is installed at the time
+ * and whichever thread frees it.
+ */
+
+NTL_THREAD_LOCAL static const _ntl_zallocator *_ntl_zalloc_cur = 0;
+
+const _ntl_zallocator *_ntl_zset_allocator(const _ntl_zallocator *a)
+{
+   const _ntl_zallocator *old = _ntl_zalloc_cur;
+   _ntl_zalloc_cur = a;
+   return old;
+}
+
+/* block with room for len digits from the installed allocator */
+static long *_ntl_zblock_new(long len)
+{
+   const _ntl_zallocator *a = _ntl_zalloc_cur;
+   long *raw;
+
+   if (a)
+      raw = (long *) a->alloc(a->ctx, (len+3)*((long)sizeof(long)));
+   else if (!(raw = _ntl_zcache_get(len)))
+      raw = (long *) NTL_MALLOC(len, sizeof(long), 3*sizeof(long));
+
+   if (!raw) MemoryError();
+
+   *((const _ntl_zallocator **) raw) = a;
+   raw[1] = len << 1;
+   return raw;
+}
+
+static void _ntl_zblock_release(long *raw)
+{
+   const _ntl_zallocator *a = _ntl_zowner(raw);
+
+   if (a)
+      a->free(a->ctx, raw);
+   else if (!_ntl_zcache_put(raw))
+      free((void*)raw);
+}
+
+
+/*
+ * Per-thread arena.
+ *
+ * Blocks of up to ARENA_CLASSES*ARENA_GRAIN bytes are cut from
+ * ARENA_CHUNK-byte chunks by bumping a pointer, and go back to a free
+ * list per size class when freed; larger blocks come from malloc.
+ * Each block carries a header naming its arena and size class.  A block
+ * freed by another thread, or after its thread has exited, is pushed on
+ * the arena's remote list, which the owner drains when a free list runs
+ * dry and in _ntl_zarena_reset.  The reset rewinds the arena only when
+ * none of its blocks is live; otherwise blocks keep being recycled
+ * through the free lists.
+ */
+
+#define ARENA_GRAIN (64)
+#define ARENA_CLASSES (64)
+#define ARENA_CHUNK (1L << 16)
+
+struct _ntl_zarena_blk {
+   struct _ntl_zarena_state *arena;
+   long cls;
+};
+
+struct _ntl_zarena_state {
+   _ntl_zallocator hook;
+   char *chunks;            /* newest first, linked through the first word */
+   char *top, *end;         /* free part of the newest chunk */
+   void *head[ARENA_CLASSES];
+   long live;               /* blocks handed out and not freed locally */
+   long orphan;
+
+#ifdef NTL_THREADS
+   std::atomic<void *> remote;
+#else
+   void *remote;
+#endif
+};
+
+NTL_THREAD_LOCAL static _ntl_zarena_state *_ntl_zarena_mine = 0;
+
+static inline void _ntl_zarena_link(void *p, void *next)
+{
+   *((void **) p) = next;
+}
+
+static inline void *_ntl_zarena_next(void *p)
+{
+   return *((void **) p);
+}
+
+static void _ntl_zarena_put(_ntl_zarena_state *A, _ntl_zarena_blk *b)
+{
+   if (b->cls < 0) 
+      free((void*)b);
+   else {
+      _ntl_zarena_link(b+1, A->head[b->cls]);
+      A->head[b->cls] = b+1;
+   }
+   A->live--;
+}
+
+static void _ntl_zarena_drain(_ntl_zarena_state *A)
+{
+#ifdef NTL_THREADS
+   void *p = A->remote.exchange(0, std::memory_order_acquire);
+#else
+   void *p = A->remote;
+   A->remote = 0;
+#endif
+
+   while (p) {
+      void *next = _ntl_zarena_next(p);
+      _ntl_zarena_put(A, ((_ntl_zarena_blk *) p) - 1);
+      p = next;
+   }
+}
+
+static void *_ntl_zarena_alloc(void *ctx, long n)
+{
+   _ntl_zarena_state *A = (_ntl_zarena_state *) ctx;
+   long bytes = n + ((long) sizeof(_ntl_zarena_blk));
+   long cls = (bytes + (ARENA_GRAIN-1))/ARENA_GRAIN - 1;
+   _ntl_zarena_blk *b;
+
+   if (cls >= ARENA_CLASSES) {
+      if (!(b = (_ntl_zarena_blk *) malloc(bytes))) return 0;
+      cls = -1;
+   }
+   else {
+      void *p = A->head[cls];
+#ifdef NTL_THREADS
+      if (!p && A->remote.load(std::memory_order_relaxed)) {
+#else
+      if (!p && A->remote) {
+#endif
+         _ntl_zarena_drain(A);
+         p = A->head[cls];
+      }
+
+      if (p) {
+         A->head[cls] = _ntl_zarena_next(p);
+         b = ((_ntl_zarena_blk *) p) - 1;
+      }
+      else {
+         long sz = (cls+1)*ARENA_GRAIN;
+         if (A->end - A->top < sz) {
+            char *c = (char *) malloc(ARENA_CHUNK);
+            if (!c) return 0;
+            _ntl_zarena_link(c, A->chunks);
+            A->chunks = c;
+            A->top = c + ARENA_GRAIN;
+            A->end = c + ARENA_CHUNK;
+         }
+         b = (_ntl_zarena_blk *) A->top;
+         A->top += sz;
+      }
+   }
+
+   b->arena = A;
+   b->cls = cls;
+   A->live++;
+   return (void *) (b+1);
+}
+
+static void _ntl_zarena_free(void *ctx, void *p)
+{
+   _ntl_zarena_state *A = (_ntl_zarena_state *) ctx;
+
+   if (A == _ntl_zarena_mine) {
+      _ntl_zarena_put(A, ((_ntl_zarena_blk *) p) - 1);
+      return;
+   }
+
+#ifdef NTL_THREADS
+   void *old = A->remote.load(std::memory_order_relaxed);
+   do {
+      _ntl_zarena_link(p, old);
+   } while (!A->remote.compare_exchange_weak(old, p, 
+                std::memory_order_release, std::memory_order_relaxed));
+#else
+   _ntl_zarena_link(p, A->remote);
+   A->remote = p;
+#endif
+}
+
+/* releases all chunks but the newest one */
+static void _ntl_zarena_trim(_ntl_zarena_state *A, long keep)
+{
+   char *c = A->chunks;
+   if (!c) return;
+
+   char *rest = (char *) _ntl_zarena_next(c);
+   if (!keep) {
+      rest = c;
+      A->chunks = 0;
+      A->top = A->end = 0;
+   }
+   else {
+      _ntl_zarena_link(c, 0);
+      A->top = c + ARENA_GRAIN;
+      A->end = c + ARENA_CHUNK;
+   }
+
+   while (rest) {
+      char *next = (char *) _ntl_zarena_next(rest);
+      free((void*)rest);
+      rest = next;
+   }
+
+   for (long i = 0; i < ARENA_CLASSES; i++) A->head[i] = 0;
+}
+
+class _ntl_zarena_guard {
+public:
+   long used;
+
+   ~_ntl_zarena_guard()
+   {
+      _ntl_zarena_state *A = _ntl_zarena_mine;
+      if (!A) return;
+
+      _ntl_zarena_drain(A);
+      _ntl_zarena_mine = 0;
+      if (A->live == 0) {
+         _ntl_zarena_trim(A, 0);
+         delete A;
+      }
+      else {
+         // live blocks keep working; frees from now on go to the
+         // remote list and the arena itself is never released
+         A->orphan = 1;
+      }
+   }
+};
+
+NTL_THREAD_LOCAL static _ntl_zarena_guard _ntl_zarena_exit;
+
+const _ntl_zallocator *_ntl_zarena(void)
+{
+   _ntl_zarena_state *A = _ntl_zarena_mine;
+
+   if (!A) {
+      A = NTL_NEW_OP _ntl_zarena_state;
+      if (!A) MemoryError();
+      A->hook.alloc = _ntl_zarena_alloc;
+      A->hook.free = _ntl_zarena_free;
+      A->hook.ctx = A;
+      A->chunks = A->top = A->end = 0;
+      for (long i = 0; i < ARENA_CLASSES; i++) A->head[i] = 0;
+      A->live = 0;
+      A->orphan = 0;
+      A->remote = 0;
+
+      _ntl_zarena_exit.used = 1;
+      _ntl_zarena_mine = A;
+   }
+
+   return &A->hook;
+}
+
+void _ntl_zarena_reset(void)
+{
+   _ntl_zarena_state *A = _ntl_zarena_mine;
+   if (!A) return;
+
+   _ntl_zarena_drain(A);
+   if (A->live == 0) _ntl_zarena_trim(A, 1);
+}
+
+
 void _ntl_zsetlength(_ntl_verylong *v, long len)
 {
    _ntl_verylong x = *v;
@@ -1435,6 +1831,7 @@ void _ntl_zsetlength(_ntl_verylong *v, long len)
 
       if (len <= oldlen) return;
 
+      long cap = oldlen;
       len++;  /* always allocate at least one more than requested */
 
       oldlen = (long) (oldlen * 1.2); /* always increase by at least 20% */
@@ -1448,12 +1845,23 @@ void _ntl_zsetlength(_ntl_verylong *v, long len)
       if (NTL_OVERFLOW(len, NTL_NBITS, 0))
          ResourceError("size too big in _ntl_zsetlength");
 
-      x--;
-      if (!(x = (_ntl_verylong)NTL_REALLOC(x, 
-                  len, sizeof(long), 2*sizeof(long)))) {
-         MemoryError();
+      long *raw = x - 2;
+      if (!_ntl_zalloc_cur && !_ntl_zowner(raw) && !_ntl_zcache_avail(len)) {
+         // malloc block staying with malloc: let realloc grow it in place
+         if (!(raw = (long *) NTL_REALLOC(raw, 
+                     len, sizeof(long), 3*sizeof(long)))) {
+            MemoryError();
+         }
+         raw[1] = len << 1;
+      }
+      else {
+         // copy the size word and the digits, release the old block
+         long *y = _ntl_zblock_new(len);
+         for (long i = 2; i <= cap+2; i++) y[i] = raw[i];
+         _ntl_zblock_release(raw);
+         raw = y;
       }
-      x[0] = len << 1;
+      x = raw + 2;
    }
    else {
       len++; /* as above, always allocate one more than requested */
@@ -1463,31 +1871,24 @@ void _ntl_zsetlength(_ntl_verylong *v, long len)
       if (NTL_OVERFLOW(len, NTL_NBITS, 0))
          ResourceError("size too big in _ntl_zsetlength");
 
-
-      if (!(x = (_ntl_verylong)NTL_MALLOC(len, 
-                  sizeof(long), 2*sizeof(long)))) {
-         MemoryError();
-      }
-      x[0] = len << 1;
-      x[1] = 1;
-      x[2] = 0;
+      long *raw = _ntl_zblock_new(len);
+      raw[2] = 1;
+      raw[3] = 0;
+      x = raw + 2;
    }
 
-   *v = x+1;
+   *v = x;
 }
 
 void _ntl_zfree(_ntl_verylong *x)
 {
-   _ntl_verylong y;
-
    if (!(*x))
       return;
 
    if ((*x)[-1] & 1)
       LogicError("Internal error: can't free this _ntl_verylong");
 
-   y = (*x - 1);
-   free((void*)y);
+   _ntl_zblock_release(*x - 2);
    *x = 0;
 }
 
@@ -4205,6 +4606,306 @@ zxxeucl(
    return (e);
 }
 
+#if (NTL_BITS_PER_LONG >= 64)
+
+/* Binary extended gcd for odd moduli of moderate size (T. Pornin,
+   "Optimized Binary GCD for Modular Inversion", 2020).
+
+   Operands are repacked into ZINV_W-bit limbs.  Each round runs
+   ZINV_W steps of the binary gcd on 2*ZINV_W+2-bit approximations of 
+   a and b (exact low bits, exact top bits), collecting the steps in 
+   a 2x2 matrix with entries bounded by 2^ZINV_W; the matrix is then
+   applied to the full-size a, b and (with division by 2^ZINV_W done
+   by Montgomery reduction) to the cofactors u, v.
+   This replaces the many short divisions of zxxeucl by one pass over
+   the operands per ZINV_W bits of progress.  */
+
+#define ZINV_W (30)
+#define ZINV_MASK ((1L << ZINV_W) - 1)
+#define ZINV_MAX_LIMBS (36)
+#define ZINV_MAX_DIGITS ((ZINV_MAX_LIMBS*ZINV_W)/NTL_NBITS - 1)
+
+static
+void zinv_to_limbs(long *x, long len, _ntl_verylong a)
+{
+   long sa = a[0];
+   long i;
+
+   for (i = 0; i < len; i++) {
+      long pos = i*ZINV_W;
+      long d = pos/NTL_NBITS;
+      long got = -(pos - d*NTL_NBITS);
+      unsigned long v = 0;
+
+      while (got < ZINV_W && d < sa) {
+         if (got < 0)
+            v |= ((unsigned long) a[d+1]) >> (-got);
+         else
+            v |= ((unsigned long) a[d+1]) << got;
+         got += NTL_NBITS;
+         d++;
+      }
+
+      x[i] = (long) (v & ZINV_MASK);
+   }
+}
+
+static
+void zinv_from_limbs(_ntl_verylong *zz, const long *x, long len)
+{
+   long nd = (len*ZINV_W + NTL_NBITS - 1)/NTL_NBITS;
+   long j;
+   _ntl_verylong z;
+
+   _ntl_zsetlength(zz, nd);
+   z = *zz;
+
+   for (j = 0; j < nd; j++) {
+      long pos = j*NTL_NBITS;
+      long i = pos/ZINV_W;
+      long o = pos - i*ZINV_W;
+      long got = -o;
+      unsigned long v = 0;
+
+      while (got < NTL_NBITS && i < len) {
+         if (got < 0) 
+            v |= ((unsigned long) x[i]) >> (-got);
+         else
+            v |= ((unsigned long) x[i]) << got;
+         got += ZINV_W;
+         i++;
+      }
+
+      z[j+1] = (long) (v & ((1UL << NTL_NBITS) - 1));
+   }
+
+   while (nd > 1 && !z[nd]) nd--;
+   z[0] = nd;
+   if (nd == 1 && !z[1]) z[0] = 1;
+}
+
+static 
+long zinv_bits(const long *x, long len)
+{
+   long i = len-1;
+   long k = 0;
+   long t;
+
+   while (i >= 0 && !x[i]) i--;
+   if (i < 0) return 0;
+   t = x[i];
+   while (t) { k++; t >>= 1; }
+   return i*ZINV_W + k;
+}
+
+static
+unsigned long zinv_extract(const long *x, long len, long pos)
+// bits pos..pos+ZINV_W+1 of x
+{
+   unsigned long v = 0;
+   long i = pos/ZINV_W;
+   long o = pos - i*ZINV_W;
+   long got = -o;
+
+   while (got < ZINV_W+2 && i < len) {
+      if (got < 0)
+         v |= ((unsigned long) x[i]) >> (-got);
+      else
+         v |= ((unsigned long) x[i]) << got;
+      got += ZINV_W;
+      i++;
+   }
+
+   return v & ((1UL << (ZINV_W+2)) - 1);
+}
+
+static
+long zinv_div_exact(long t)
+// t/2^ZINV_W rounded towards -infinity
+{
+   return (t - (t & ZINV_MASK)) / (1L << ZINV_W);
+}
+
+static
+long zinv_lincomb(long *r, const long *a, const long *b, long len, 
+                  long f, long g)
+// r = (a*f + b*g)/2^ZINV_W; returns -1 if the result is negative 
+// (r then holds its absolute value), 1 otherwise
+
+{
+   long i, t, c;
+
+   t = a[0]*f + b[0]*g;
+   c = zinv_div_exact(t);
+   for (i = 1; i < len; i++) {
+      t = a[i]*f + b[i]*g + c;
+      r[i-1] = t & ZINV_MASK;
+      c = zinv_div_exact(t);
+   }
+   r[len-1] = c & ZINV_MASK;
+
+   if (c >= 0) return 1;
+
+   c = 1;
+   for (i = 0; i < len; i++) {
+      t = ((~r[i]) & ZINV_MASK) + c;
+      r[i] = t & ZINV_MASK;
+      c = t >> ZINV_W;
+   }
+
+   return -1;
+}
+
+static
+void zinv_lincomb_mod(long *r, const long *u, const long *v, long len,
+                      long f, long g, const long *m, long minv)
+// r = (u*f + v*g)/2^ZINV_W mod m, for 0 <= u, v < m, |f|+|g| <= 2^ZINV_W
+
+{
+   long i, t, c, q;
+
+   t = u[0]*f + v[0]*g;
+   q = (long) ((-((unsigned long) t) * (unsigned long) minv) & ZINV_MASK);
+   t += q*m[0];
+   c = zinv_div_exact(t);
+   for (i = 1; i < len; i++) {
+      t = u[i]*f + v[i]*g + q*m[i] + c;
+      r[i-1] = t & ZINV_MASK;
+      c = zinv_div_exact(t);
+   }
+
+   // r + c*2^(ZINV_W*(len-1)) lies in (-m, 2m)
+
+   while (c < 0) {
+      long cc = 0;
+      for (i = 0; i < len-1; i++) {
+         t = r[i] + m[i] + cc;
+         r[i] = t & ZINV_MASK;
+         cc = t >> ZINV_W;
+      }
+      c += cc + m[len-1];
+   }
+
+   r[len-1] = c;
+
+   for (;;) {
+      for (i = len-1; i >= 0 && r[i] == m[i]; i--) ;
+      if (i >= 0 && r[i] < m[i]) break;
+
+      long cc = 0;
+      for (i = 0; i < len; i++) {
+         t = r[i] - m[i] + cc;
+         r[i] = t & ZINV_MASK;
+         cc = zinv_div_exact(t);
+      }
+   }
+}
+
+static
+long zinv_binary(_ntl_verylong ain, _ntl_verylong nin, _ntl_verylong *invv)
+// inverse of 0 < ain < nin, nin odd, nin[0] <= ZINV_MAX_DIGITS;
+// returns 0 if ain is not invertible (nothing is written then)
+
+{
+   long a[ZINV_MAX_LIMBS], b[ZINV_MAX_LIMBS];
+   long u[ZINV_MAX_LIMBS], v[ZINV_MAX_LIMBS];
+   long m[ZINV_MAX_LIMBS];
+   long t0[ZINV_MAX_LIMBS], t1[ZINV_MAX_LIMBS];
+   long len, i, j, rounds, maxrounds;
+   unsigned long minv;
+
+   // one spare limb so that m[len-1] = 0 below the sign position
+   len = (nin[0]*NTL_NBITS + ZINV_W - 1)/ZINV_W + 1;
+
+   zinv_to_limbs(a, len, ain);
+   zinv_to_limbs(m, len, nin);
+   for (i = 0; i < len; i++) {
+      b[i] = m[i];
+      u[i] = 0;
+      v[i] = 0;
+   }
+   u[0] = 1;
+
+   minv = (unsigned long) m[0];
+   for (i = 0; i < 5; i++)
+      minv *= 2 - minv*((unsigned long) m[0]);
+
+   maxrounds = (2*zinv_bits(m, len))/(ZINV_W-1) + 4;
+
+   for (rounds = 0; ; rounds++) {
+      long na, nb, n;
+      unsigned long xa, xb;
+      long f0, g0, f1, g1, sa, sb;
+
+      na = zinv_bits(a, len);
+      if (na == 0) break;
+      if (rounds >= maxrounds) return -1;
+
+      nb = zinv_bits(b, len);
+      n = na > nb ? na : nb;
+      if (n < 2*ZINV_W+2) n = 2*ZINV_W+2;
+
+      // approximations: low ZINV_W bits and top ZINV_W+2 bits
+
+      xa = ((unsigned long) a[0]) | 
+           (zinv_extract(a, len, n-ZINV_W-2) << ZINV_W);
+      xb = ((unsigned long) b[0]) | 
+           (zinv_extract(b, len, n-ZINV_W-2) << ZINV_W);
+
+      // branch-free steps: odd = all ones if xa is odd, 
+      // sw = all ones if, in addition, xa < xb
+
+      f0 = 1; g0 = 0; f1 = 0; g1 = 1;
+      for (j = 0; j < ZINV_W; j++) {
+         unsigned long odd = -(xa & 1);
+         unsigned long sw = odd & -((unsigned long) (xa < xb));
+         unsigned long xt = (xa ^ xb) & sw;
+         long ft = (f0 ^ f1) & (long) sw;
+         long gt = (g0 ^ g1) & (long) sw;
+
+         xa ^= xt; xb ^= xt;
+         f0 ^= ft; f1 ^= ft;
+         g0 ^= gt; g1 ^= gt;
+
+         xa -= xb & odd;
+         f0 -= f1 & (long) odd;
+         g0 -= g1 & (long) odd;
+
+         xa >>= 1;
+         f1 <<= 1;
+         g1 <<= 1;
+      }
+
+      sa = zinv_lincomb(t0, a, b, len, f0, g0);
+      sb = zinv_lincomb(t1, a, b, len, f1, g1);
+      for (i = 0; i < len; i++) {
+         a[i] = t0[i];
+         b[i] = t1[i];
+      }
+      if (sa < 0) { f0 = -f0; g0 = -g0; }
+      if (sb < 0) { f1 = -f1; g1 = -g1; }
+
+      zinv_lincomb_mod(t0, u, v, len, f0, g0, m, (long) minv);
+      zinv_lincomb_mod(t1, u, v, len, f1, g1, m, (long) minv);
+      for (i = 0; i < len; i++) {
+         u[i] = t0[i];
+         v[i] = t1[i];
+      }
+   }
+
+   // a = 0, b = gcd, v = ain^{-1}*b
+
+   if (b[0] != 1) return 0;
+   for (i = 1; i < len; i++)
+      if (b[i]) return 0;
+
+   zinv_from_limbs(invv, v, len);
+   return 1;
+}
+
+#endif
+
+
 long 
 _ntl_zinv(
         _ntl_verylong ain,
@@ -4237,6 +4938,12 @@ _ntl_zinv(
         }
 
 
+#if (NTL_BITS_PER_LONG >= 64)
+        if ((nin[1] & 1) && nin[0] <= ZINV_MAX_DIGITS &&
+            zinv_binary(ain, nin, invv) > 0)
+                return 0;
+#endif
+
         if (!(zxxeucl(ain, nin, &v, &u))) {
                 if (_ntl_zsign(v) < 0) _ntl_zadd(v, nin, &v);
                 _ntl_zcopy(v, invv);
@@ -6682,3 +7389,139 @@ _ntl_zsubmul(_ntl_verylong x, _ntl_verylong y,  _ntl_verylong *ww)
 }
 
 
+
+
+
+/* Data structures and algorithms for repeated reduction 
+   modulo a fixed modulus */
+
+
+class _ntl_reduce_struct_plain : public _ntl_reduce_struct {
+public:
+   _ntl_verylong_wrapped N;
+
+   void eval(_ntl_verylong *x, _ntl_verylong *a)
+   {
+      _ntl_zmod(*a, N, x);
+   }
+
+   void adjust(_ntl_verylong *x) { }
+};
+
+
+/* Montgomery reduction with R = NTL_RADIX^n, where n is the number
+   of digits of the (odd) modulus N.  Each step clears the low digit 
+   by adding a multiple of N, so the reduction costs about n^2 digit 
+   multiplications, with no quotient estimates and no corrections. */
+
+class _ntl_reduce_struct_montgomery : public _ntl_reduce_struct {
+public:
+   long n;
+   long inv;  /* -N^{-1} mod NTL_RADIX */
+   _ntl_verylong_wrapped N;
+
+   void eval(_ntl_verylong *x, _ntl_verylong *a);
+   void adjust(_ntl_verylong *x);
+};
+
+
+void _ntl_reduce_struct_montgomery::eval(_ntl_verylong *rres, _ntl_verylong *aa)
+{
+   _ntl_verylong a = *aa;
+   long n = this->n;
+   long sa, i;
+   long *r;
+   CRegister(t);
+
+   if (!a || (((sa = a[0]) == 1) && (!a[1]))) {
+      _ntl_zzero(rres);
+      return;
+   }
+
+   if (sa < 0 || sa > 2*n) 
+      LogicError("_ntl_reduce_struct_montgomery: bad args");
+
+   _ntl_zsetlength(&t, 2*n+1);
+
+   for (i = 1; i <= sa; i++) t[i] = a[i];
+   for (; i <= 2*n+1; i++) t[i] = 0;
+
+   for (i = 1; i <= n; i++) {
+      long m = (long) ((((unsigned long) t[i]) * ((unsigned long) inv)) 
+                       & NTL_RADIXM);
+      if (m) zaddmul(m, &t[i], N);
+      t[i+n+1] += t[i+n] >> NTL_NBITS;
+      t[i+n] &= NTL_RADIXM;
+   }
+
+   /* t[1..n] are now zero, and the result t[n+1..2n+1] is less than 2N;
+      t[n] serves as its size word */
+
+   r = &t[n];
+   i = n+1;
+   while (i > 1 && r[i] == 0) i--;
+   r[0] = i;
+
+   if (_ntl_zcompare(r, N) >= 0)
+      _ntl_zsub(r, N, rres);
+   else
+      _ntl_zcopy(r, rres);
+
+   t[0] = 1;
+   t[1] = 0;
+}
+
+
+void _ntl_reduce_struct_montgomery::adjust(_ntl_verylong *x)
+{
+   CRegister(t);
+
+   _ntl_zlshift(*x, n*NTL_NBITS, &t);
+   _ntl_zmod(t, N, x);
+}
+
+
+
+_ntl_reduce_struct *
+_ntl_reduce_struct_build(_ntl_verylong modulus, _ntl_verylong excess)
+{
+   if (_ntl_zscompare(modulus, 1) <= 0)
+      LogicError("_ntl_reduce_struct_build: bad args");
+
+   if (_ntl_zodd(modulus)) {
+      long n = modulus[0];
+      CRegister(bound);
+
+      _ntl_zlshift(modulus, n*NTL_NBITS, &bound);
+
+      if (_ntl_zcompare(excess, bound) <= 0) {
+         UniquePtr<_ntl_reduce_struct_montgomery> res;
+         res.make();
+
+         res->n = n;
+         _ntl_zcopy(modulus, &res->N);
+
+         /* Newton iteration for N^{-1} mod 2^NTL_BITS_PER_LONG: 
+            each step doubles the number of correct low bits, 
+            starting from 3 */
+
+         unsigned long p1 = (unsigned long) modulus[1];
+         unsigned long x = p1;
+         for (long i = 3; i < NTL_BITS_PER_LONG; i *= 2)
+            x *= 2 - p1*x;
+
+         res->inv = (long) ((-x) & NTL_RADIXM);
+
+         return res.release();
+      }
+   }
+
+   {
+      UniquePtr<_ntl_reduce_struct_plain> res;
+      res.make();
+
+      _ntl_zcopy(modulus, &res->N);
+
+      return res.release();
+   }
+}
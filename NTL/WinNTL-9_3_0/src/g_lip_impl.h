@@ -5489,3 +5489,36 @@ _ntl_gsubmul(_ntl_gbigint x, _ntl_gbigint y,  _ntl_gbigint *ww)
 
 
 
+
+
+
+/* Data structures and algorithms for repeated reduction 
+   modulo a fixed modulus */
+
+
+class _ntl_reduce_struct_plain : public _ntl_reduce_struct {
+public:
+   _ntl_gbigint_wrapped N;
+
+   void eval(_ntl_gbigint *x, _ntl_gbigint *a)
+   {
+      _ntl_gmod(*a, N, x);
+   }
+
+   void adjust(_ntl_gbigint *x) { }
+};
+
+
+_ntl_reduce_struct *
+_ntl_reduce_struct_build(_ntl_gbigint modulus, _ntl_gbigint excess)
+{
+   if (_ntl_gscompare(modulus, 1) <= 0)
+      LogicError("_ntl_reduce_struct_build: bad args");
+
+   UniquePtr<_ntl_reduce_struct_plain> res;
+   res.make();
+
+   _ntl_gcopy(modulus, &res->N);
+
+   return res.release();
+}
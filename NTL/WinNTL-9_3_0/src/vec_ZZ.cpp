@@ -1,21 +1,61 @@
 
 #include <NTL/vec_ZZ.h>
+#include <NTL/BasicThreadPool.h>
 
 NTL_START_IMPL
 
 
-void InnerProduct(ZZ& xx, const vec_ZZ& a, const vec_ZZ& b)
+// The loops below are split over the thread pool only when there is
+// enough work to pay for it: about n times the digits of a typical 
+// element.
+
+#define VEC_ZZ_PAR_WORK (1L << 14)
+
+static
+bool VecZZSeq(long n, const ZZ& typ)
 {
-   ZZ t1, x;
+   if (n <= 1 || GetThreadPool()->NumThreads() <= 1) return true;
+   long digits = NumBits(typ)/NTL_ZZ_NBITS + 1;
+   return n < VEC_ZZ_PAR_WORK/digits;
+}
 
-   long n = min(a.length(), b.length());
-   long i;
+static
+bool VecZZSeq(const vec_ZZ& a)
+{
+   long n = a.length();
+   return n <= 1 || VecZZSeq(n, a[0]);
+}
 
-   clear(x);
-   for (i = 1; i <= n; i++) {
-      mul(t1, a(i), b(i));
-      add(x, x, t1);
+
+void InnerProduct(ZZ& xx, const vec_ZZ& a, const vec_ZZ& b)
+{
+   long n = min(a.length(), b.length());
+   const ZZ *ap = a.elts();
+   const ZZ *bp = b.elts();
+
+   // partial sums over nc consecutive ranges, added up in order
+
+   bool seq = (n <= 1 || VecZZSeq(n, ap[0]));
+   long nc = seq ? 1 : min(n, 4*GetThreadPool()->NumThreads());
+
+   Vec<ZZ> part;
+   part.SetLength(nc);
+
+   NTL_GEXEC_RANGE(seq, nc, first, last)
+   for (long c = first; c < last; c++) {
+      ZZ t1, x;
+      long lo = (n*c)/nc, hi = (n*(c+1))/nc;
+      for (long i = lo; i < hi; i++) {
+         mul(t1, ap[i], bp[i]);
+         add(x, x, t1);
+      }
+      part[c] = x;
    }
+   NTL_EXEC_RANGE_END
+
+   ZZ x;
+   for (long c = 0; c < nc; c++)
+      add(x, x, part[c]);
 
    xx = x;
 }
@@ -25,18 +65,22 @@ void mul(vec_ZZ& x, const vec_ZZ& a, const ZZ& b_in)
    ZZ b = b_in;
    long n = a.length();
    x.SetLength(n);
-   long i;
-   for (i = 0; i < n; i++)
+   bool seq = VecZZSeq(a);
+   NTL_GEXEC_RANGE(seq, n, first, last)
+   for (long i = first; i < last; i++)
       mul(x[i], a[i], b);
+   NTL_EXEC_RANGE_END
 }
 
 void mul(vec_ZZ& x, const vec_ZZ& a, long b)
 {
    long n = a.length();
    x.SetLength(n);
-   long i;
-   for (i = 0; i < n; i++)
+   bool seq = VecZZSeq(a);
+   NTL_GEXEC_RANGE(seq, n, first, last)
+   for (long i = first; i < last; i++)
       mul(x[i], a[i], b);
+   NTL_EXEC_RANGE_END
 }
 
 void add(vec_ZZ& x, const vec_ZZ& a, const vec_ZZ& b)
@@ -45,9 +89,11 @@ void add(vec_ZZ& x, const vec_ZZ& a, const vec_ZZ& b)
    if (b.length() != n) LogicError("vector add: dimension mismatch");
 
    x.SetLength(n);
-   long i;
-   for (i = 0; i < n; i++)
+   bool seq = VecZZSeq(a);
+   NTL_GEXEC_RANGE(seq, n, first, last)
+   for (long i = first; i < last; i++)
       add(x[i], a[i], b[i]);
+   NTL_EXEC_RANGE_END
 }
 
 void sub(vec_ZZ& x, const vec_ZZ& a, const vec_ZZ& b)
@@ -55,9 +101,11 @@ void sub(vec_ZZ& x, const vec_ZZ& a, const vec_ZZ& b)
    long n = a.length();
    if (b.length() != n) LogicError("vector sub: dimension mismatch");
    x.SetLength(n);
-   long i;
-   for (i = 0; i < n; i++)
+   bool seq = VecZZSeq(a);
+   NTL_GEXEC_RANGE(seq, n, first, last)
+   for (long i = first; i < last; i++)
       sub(x[i], a[i], b[i]);
+   NTL_EXEC_RANGE_END
 }
 
 void clear(vec_ZZ& x)
@@ -72,9 +120,11 @@ void negate(vec_ZZ& x, const vec_ZZ& a)
 {
    long n = a.length();
    x.SetLength(n);
-   long i;
-   for (i = 0; i < n; i++)
+   bool seq = VecZZSeq(a);
+   NTL_GEXEC_RANGE(seq, n, first, last)
+   for (long i = first; i < last; i++)
       negate(x[i], a[i]);
+   NTL_EXEC_RANGE_END
 }
 
 
@@ -1,74 +1,193 @@
 #include <NTL/ZZ.h>
 #include <iostream>
 #include<cstring>
+#include<cstdlib>
+#include<vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "convert.h"
 
 using namespace std;
 using namespace NTL;
+
+static const char hex_digits[16] = {'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'};
+
+// ky tu khong phai hex duoc doc la 0, giong switch cu
+static const signed char hex_values[256] =
+{
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,1,2,3,4,5,6,7,8,9,0,0,0,0,0,0,
+    0,10,11,12,13,14,15,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,10,11,12,13,14,15,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+};
+
 char convIntToChar(int a)
 {
-    switch(toupper(a)){
-        case 0: return '0';
-        case 1: return '1';
-        case 2: return '2';
-        case 3: return '3';
-        case 4: return '4';
-        case 5: return '5';
-        case 6: return '6';
-        case 7: return '7';
-        case 8: return '8';
-        case 9: return '9';
-        case 10: return 'a';
-        case 11: return 'b';
-        case 12: return 'c';
-        case 13: return 'd';
-        case 14: return 'e';
-        case 15: return 'f';
-        default:
-            return '0';
-    }
+    if(a < 0 || a > 15) return '0';
+    return hex_digits[a];
 }
 int convCharToInt(char c)
 {
-    switch(toupper(c)){
-        case '0': return 0;
-        case '1': return 1;
-        case '2': return 2;
-        case '3': return 3;
-        case '4': return 4;
-        case '5': return 5;
-        case '6': return 6;
-        case '7': return 7;
-        case '8': return 8;
-        case '9': return 9;
-        case 'A': return 10;
-        case 'B': return 11;
-        case 'C': return 12;
-        case 'D': return 13;
-        case 'E': return 14;
-        case 'F': return 15;
-        default:
-            return 0;
+    return hex_values[(unsigned char)c];
+}
+
+#if defined(__SSE2__)
+// 16 ky tu hex -> 16 gia tri 0..15
+static inline __m128i hex_nibbles_16(__m128i c)
+{
+    const __m128i l = _mm_or_si128(c,_mm_set1_epi8(0x20));
+    const __m128i d = _mm_sub_epi8(c,_mm_set1_epi8('0'));
+    const __m128i h = _mm_sub_epi8(l,_mm_set1_epi8('a' - 10));
+    const __m128i isd = _mm_and_si128(_mm_cmpgt_epi8(c,_mm_set1_epi8('0' - 1)),
+                                      _mm_cmplt_epi8(c,_mm_set1_epi8('9' + 1)));
+    const __m128i ish = _mm_and_si128(_mm_cmpgt_epi8(l,_mm_set1_epi8('a' - 1)),
+                                      _mm_cmplt_epi8(l,_mm_set1_epi8('f' + 1)));
+    return _mm_or_si128(_mm_and_si128(isd,d),_mm_and_si128(ish,h));
+}
+
+// 16 gia tri 0..15 -> 16 ky tu '0'..'9','a'..'f'
+static inline __m128i hex_chars_16(__m128i v)
+{
+    const __m128i gt9 = _mm_cmpgt_epi8(v,_mm_set1_epi8(9));
+    const __m128i c = _mm_add_epi8(v,_mm_set1_epi8('0'));
+    return _mm_add_epi8(c,_mm_and_si128(gt9,_mm_set1_epi8('a' - '0' - 10)));
+}
+#endif
+
+#if defined(__AVX2__)
+static inline __m256i hex_nibbles_32(__m256i c)
+{
+    const __m256i l = _mm256_or_si256(c,_mm256_set1_epi8(0x20));
+    const __m256i d = _mm256_sub_epi8(c,_mm256_set1_epi8('0'));
+    const __m256i h = _mm256_sub_epi8(l,_mm256_set1_epi8('a' - 10));
+    const __m256i isd = _mm256_andnot_si256(_mm256_cmpgt_epi8(c,_mm256_set1_epi8('9')),
+                                            _mm256_cmpgt_epi8(c,_mm256_set1_epi8('0' - 1)));
+    const __m256i ish = _mm256_andnot_si256(_mm256_cmpgt_epi8(l,_mm256_set1_epi8('f')),
+                                            _mm256_cmpgt_epi8(l,_mm256_set1_epi8('a' - 1)));
+    return _mm256_or_si256(_mm256_and_si256(isd,d),_mm256_and_si256(ish,h));
+}
+
+static inline __m256i hex_chars_32(__m256i v)
+{
+    const __m256i gt9 = _mm256_cmpgt_epi8(v,_mm256_set1_epi8(9));
+    const __m256i c = _mm256_add_epi8(v,_mm256_set1_epi8('0'));
+    return _mm256_add_epi8(c,_mm256_and_si256(gt9,_mm256_set1_epi8('a' - '0' - 10)));
+}
+#endif
+
+// b gom 2n ky tu hex -> a gom n byte
+static void hex_decode(unsigned char* a,const char* b,long n)
+{
+    long i = 0;
+#if defined(__AVX2__)
+    for(; i + 16 <= n; i += 16)
+    {
+        __m256i v = hex_nibbles_32(_mm256_loadu_si256((const __m256i*)(b + 2*i)));
+        // byte chan la nibble cao, byte le la nibble thap
+        v = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(v,_mm256_set1_epi16(0x00FF)),4),
+                            _mm256_srli_epi16(v,8));
+        v = _mm256_permute4x64_epi64(_mm256_packus_epi16(v,v),0x08);
+        _mm_storeu_si128((__m128i*)(a + i),_mm256_castsi256_si128(v));
+    }
+#endif
+#if defined(__SSE2__)
+    for(; i + 8 <= n; i += 8)
+    {
+        __m128i v = hex_nibbles_16(_mm_loadu_si128((const __m128i*)(b + 2*i)));
+        v = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v,_mm_set1_epi16(0x00FF)),4),
+                         _mm_srli_epi16(v,8));
+        _mm_storel_epi64((__m128i*)(a + i),_mm_packus_epi16(v,v));
+    }
+#endif
+    for(; i < n; i++)
+        a[i] = (unsigned char)(hex_values[(unsigned char)b[2*i]] << 4 | hex_values[(unsigned char)b[2*i+1]]);
+}
+
+// b gom n byte -> a gom 2n ky tu hex (khong them '\0')
+static void hex_encode(char* a,const unsigned char* b,long n)
+{
+    long i = 0;
+#if defined(__AVX2__)
+    for(; i + 32 <= n; i += 32)
+    {
+        const __m256i mask = _mm256_set1_epi8(0x0F);
+        __m256i v = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i hi = hex_chars_32(_mm256_and_si256(_mm256_srli_epi16(v,4),mask));
+        __m256i lo = hex_chars_32(_mm256_and_si256(v,mask));
+        __m256i x0 = _mm256_unpacklo_epi8(hi,lo);
+        __m256i x1 = _mm256_unpackhi_epi8(hi,lo);
+        _mm256_storeu_si256((__m256i*)(a + 2*i),_mm256_permute2x128_si256(x0,x1,0x20));
+        _mm256_storeu_si256((__m256i*)(a + 2*i + 32),_mm256_permute2x128_si256(x0,x1,0x31));
+    }
+#endif
+#if defined(__SSE2__)
+    for(; i + 16 <= n; i += 16)
+    {
+        const __m128i mask = _mm_set1_epi8(0x0F);
+        __m128i v = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i hi = hex_chars_16(_mm_and_si128(_mm_srli_epi16(v,4),mask));
+        __m128i lo = hex_chars_16(_mm_and_si128(v,mask));
+        _mm_storeu_si128((__m128i*)(a + 2*i),_mm_unpacklo_epi8(hi,lo));
+        _mm_storeu_si128((__m128i*)(a + 2*i + 16),_mm_unpackhi_epi8(hi,lo));
+    }
+#endif
+    for(; i < n; i++)
+    {
+        a[2*i] = hex_digits[b[i]>>4];
+        a[2*i+1] = hex_digits[b[i]&15];
     }
 }
 
 void conv_hex_to_ZZ(ZZ& a,char* b)
 {
-    a = 0;
-    for(int i=0; i<strlen(b); i++)
+    long len = strlen(b);
+    long n = (len + 1)/2;
+    if(n == 0)
+    {
+        clear(a);
+        return;
+    }
+    vector<unsigned char> buf(n);
+    unsigned char* bytes = &buf[0];
+    if(len & 1)
+    {
+        // so ky tu le: ky tu dau tien la nibble thap cua byte dau
+        bytes[0] = (unsigned char)hex_values[(unsigned char)b[0]];
+        hex_decode(bytes + 1,b + 1,n - 1);
+    }
+    else
     {
-        a = a*16 + convCharToInt(b[i]);
+        hex_decode(bytes,b,n);
     }
+    conv_bytes_to_ZZ(a,bytes,n);
 }
 void conv_ui_to_ZZ(ZZ& a,unsigned int b)
 {
     conv(a,b);
 }
+// a nhan n chu so hex thap nhat cua b
 void conv_ZZ_to_hex(char* a,ZZ b,int n)
 {
-    for(int i=1;i<=n;i++){
-        a[n-i]=convIntToChar(b%16);
-        b=b/16;
+    long len = (n + 1)/2;
+    if(len == 0)
+    {
+        a[0] = '\0';
+        return;
+    }
+    vector<unsigned char> buf(len);
+    unsigned char* bytes = &buf[0];
+    conv_ZZ_to_bytes(bytes,b,len);
+    if(n & 1)
+    {
+        a[0] = hex_digits[bytes[0]&15];
+        hex_encode(a + 1,bytes + 1,len - 1);
+    }
+    else
+    {
+        hex_encode(a,bytes,len);
     }
     a[n]='\0';
 }
@@ -78,3 +197,60 @@ void conv_ZZ_to_ui(unsigned int& a,ZZ b)
     conv(a,b);
 }
 
+// b la n byte big-endian (thu tu cua digest SHA va file khoa)
+void conv_bytes_to_ZZ(ZZ& a,const unsigned char* b,long n)
+{
+    if(n <= 0)
+    {
+        clear(a);
+        return;
+    }
+    vector<unsigned char> le(b,b + n);
+    for(long i=0,j=n-1;i<j;i++,j--)
+    {
+        unsigned char t = le[i];
+        le[i] = le[j];
+        le[j] = t;
+    }
+    ZZFromBytes(a,&le[0],n);
+}
+
+void conv_ZZ_to_bytes(unsigned char* a,const ZZ& b,long n)
+{
+    BytesFromZZ(a,b,n);
+    for(long i=0,j=n-1;i<j;i++,j--)
+    {
+        unsigned char t = a[i];
+        a[i] = a[j];
+        a[j] = t;
+    }
+}
+
+void conv_bytes_to_hex(char* a,const unsigned char* b,long n)
+{
+    hex_encode(a,b,n);
+    a[2*n]='\0';
+}
+
+void conv_hex_to_bytes(unsigned char* a,const char* b,long n)
+{
+    hex_decode(a,b,n);
+}
+
+// so nguyen khong dau n byte little-endian (header cua file nhi phan)
+unsigned long long conv_le_to_ull(const unsigned char* b,int n)
+{
+    unsigned long long v = 0;
+    for(int i = n - 1; i >= 0; i--)
+        v = (v << 8) | b[i];
+    return v;
+}
+
+void conv_ull_to_le(unsigned char* a,unsigned long long b,int n)
+{
+    for(int i = 0; i < n; i++)
+    {
+        a[i] = (unsigned char)b;
+        b >>= 8;
+    }
+}
@@ -8,3 +8,9 @@ void conv_hex_to_ZZ(ZZ& a,char* b);
 void conv_ui_to_ZZ(ZZ& a,unsigned int b);
 void conv_ZZ_to_hex(char* a,ZZ b,int n);
 void conv_ZZ_to_ui(unsigned int& a,ZZ b);
+void conv_bytes_to_ZZ(ZZ& a,const unsigned char* b,long n);
+void conv_ZZ_to_bytes(unsigned char* a,const ZZ& b,long n);
+void conv_bytes_to_hex(char* a,const unsigned char* b,long n);
+void conv_hex_to_bytes(unsigned char* a,const char* b,long n);
+unsigned long long conv_le_to_ull(const unsigned char* b,int n);
+void conv_ull_to_le(unsigned char* a,unsigned long long b,int n);
@@ -0,0 +1,347 @@
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+#include "convert.h"
+#include "encode.h"
+#include "curves.h"
+#include "corpus.h"
+
+using namespace std;
+
+static const char corpus_magic[8] = {'E','C','D','S','A','V','C','1'};
+
+static unsigned long long pad64(unsigned long long n)
+{
+    return (n + 63) & ~63ULL;
+}
+
+static unsigned long long record_bytes(const corpus_header& h)
+{
+    return h.digest_len + 2*h.scalar_len + 4;
+}
+
+static unsigned long long block_bytes(const corpus_header& h,unsigned long long n)
+{
+    return pad64(n*record_bytes(h));
+}
+
+static unsigned long long keys_bytes(const corpus_header& h)
+{
+    return pad64(h.key_count*h.point_len);
+}
+
+static void encode_header(unsigned char* out,const corpus_header& h)
+{
+    memset(out,0,64);
+    memcpy(out,corpus_magic,8);
+    conv_ull_to_le(out + 8,CORPUS_VERSION,4);
+    conv_ull_to_le(out + 12,h.digest_len,4);
+    conv_ull_to_le(out + 16,h.scalar_len,4);
+    conv_ull_to_le(out + 20,h.point_len,4);
+    conv_ull_to_le(out + 24,h.block_records,4);
+    conv_ull_to_le(out + 32,h.key_count,8);
+    conv_ull_to_le(out + 40,h.record_count,8);
+    memcpy(out + 48,h.curve_id,CORPUS_CURVE_ID_LENGTH);
+}
+
+static bool decode_header(const unsigned char* in,corpus_header& h)
+{
+    if(memcmp(in,corpus_magic,8) != 0) return false;
+    if(conv_le_to_ull(in + 8,4) != CORPUS_VERSION) return false;
+    h.digest_len = (unsigned int)conv_le_to_ull(in + 12,4);
+    h.scalar_len = (unsigned int)conv_le_to_ull(in + 16,4);
+    h.point_len = (unsigned int)conv_le_to_ull(in + 20,4);
+    h.block_records = (unsigned int)conv_le_to_ull(in + 24,4);
+    h.key_count = conv_le_to_ull(in + 32,8);
+    h.record_count = conv_le_to_ull(in + 40,8);
+    memcpy(h.curve_id,in + 48,CORPUS_CURVE_ID_LENGTH);
+    if(h.digest_len == 0 || h.digest_len > MAX_BITS2INT_BYTES) return false;
+    if(h.scalar_len == 0 || h.scalar_len > MAX_BITS2INT_BYTES) return false;
+    if(h.point_len == 0 || h.point_len > 2*MAX_BITS2INT_BYTES) return false;
+    if(h.block_records == 0 || h.block_records > CORPUS_MAX_BLOCK_RECORDS) return false;
+    // key_idx la u32; gioi han nay giu moi phep nhan ben duoi trong 64 bit
+    if(h.key_count > 0x100000000ULL) return false;
+    return true;
+}
+
+bool corpus_open(corpus_reader& rd,const char* path)
+{
+    memset(&rd,0,sizeof(rd));
+    unsigned char hdr[64];
+
+    if(strcmp(path,"-") == 0)
+    {
+#ifdef _WIN32
+        _setmode(0,_O_BINARY);
+#endif
+        rd.stream = stdin;
+        if(fread(hdr,1,64,rd.stream) != 64 || !decode_header(hdr,rd.hdr)) return false;
+        unsigned long long kb = keys_bytes(rd.hdr);
+        if(kb > (size_t)-1)
+        {
+            corpus_close(rd);
+            return false;
+        }
+        rd.key_buffer = (unsigned char*)malloc(kb ? kb : 1);
+        rd.buffer = (unsigned char*)malloc(block_bytes(rd.hdr,rd.hdr.block_records));
+        if(!rd.key_buffer || !rd.buffer || fread(rd.key_buffer,1,kb,rd.stream) != kb)
+        {
+            corpus_close(rd);
+            return false;
+        }
+        rd.keys = rd.key_buffer;
+        return true;
+    }
+
+    if(!map_file(path,rd.map)) return false;
+    if(rd.map.size < 64 || !decode_header(rd.map.data,rd.hdr))
+    {
+        corpus_close(rd);
+        return false;
+    }
+    // so tung phan voi phan con lai cua file truoc khi nhan, tranh tran so
+    const corpus_header& h = rd.hdr;
+    unsigned long long full = h.record_count / h.block_records;
+    unsigned long long last = h.record_count % h.block_records;
+    unsigned long long rest = rd.map.size - 64;
+    bool ok = keys_bytes(h) <= rest;
+    if(ok) rest -= keys_bytes(h);
+    ok = ok && block_bytes(h,last) <= rest;
+    if(ok) rest -= block_bytes(h,last);
+    ok = ok && full <= rest/block_bytes(h,h.block_records);
+    if(!ok)
+    {
+        corpus_close(rd);
+        return false;
+    }
+    rd.keys = rd.map.data + 64;
+    rd.pos = 64 + keys_bytes(h);
+    return true;
+}
+
+bool corpus_next_block(corpus_reader& rd,corpus_block& blk)
+{
+    const corpus_header& h = rd.hdr;
+    unsigned long long n = h.record_count - rd.done;
+    if(n == 0) return false;
+    if(n > h.block_records) n = h.block_records;
+
+    const unsigned char* p;
+    if(rd.stream)
+    {
+        unsigned long long len = block_bytes(h,n);
+        if(fread(rd.buffer,1,len,rd.stream) != len) return false;
+        p = rd.buffer;
+    }
+    else
+    {
+        p = rd.map.data + rd.pos;
+        rd.pos += block_bytes(h,n);
+    }
+    blk.n = (long)n;
+    blk.digests = p;
+    blk.r = p + n*h.digest_len;
+    blk.s = blk.r + n*h.scalar_len;
+    blk.key_idx = blk.s + n*h.scalar_len;
+    rd.done += n;
+    return true;
+}
+
+const unsigned char* corpus_key(const corpus_reader& rd,unsigned long long i)
+{
+    return rd.keys + i*rd.hdr.point_len;
+}
+
+unsigned long corpus_key_index(const corpus_block& blk,long i)
+{
+    return (unsigned long)conv_le_to_ull(blk.key_idx + 4*i,4);
+}
+
+void corpus_close(corpus_reader& rd)
+{
+    unmap_file(rd.map);
+    free(rd.key_buffer);
+    free(rd.buffer);
+    rd.key_buffer = 0;
+    rd.buffer = 0;
+    rd.keys = 0;
+    rd.stream = 0;
+}
+
+bool corpus_create(corpus_writer& w,const char* path,unsigned int digest_len,unsigned int scalar_len,
+                   unsigned int point_len,const unsigned char* keys,unsigned long long key_count,
+                   const unsigned char* curve_id)
+{
+    memset(&w,0,sizeof(w));
+    w.hdr.digest_len = digest_len;
+    w.hdr.scalar_len = scalar_len;
+    w.hdr.point_len = point_len;
+    w.hdr.block_records = CORPUS_BLOCK_RECORDS;
+    w.hdr.key_count = key_count;
+    w.hdr.record_count = 0;
+    if(curve_id) memcpy(w.hdr.curve_id,curve_id,CORPUS_CURVE_ID_LENGTH);
+
+    w.file = fopen(path,"wb");
+    if(!w.file) return false;
+    w.buffer = (unsigned char*)malloc(block_bytes(w.hdr,w.hdr.block_records));
+    if(!w.buffer)
+    {
+        fclose(w.file);
+        return false;
+    }
+
+    unsigned char hdr[64];
+    encode_header(hdr,w.hdr);
+    unsigned long long kb = key_count*point_len;
+    unsigned char zero[64] = {0};
+    bool ok = fwrite(hdr,1,64,w.file) == 64;
+    ok = ok && fwrite(keys,1,kb,w.file) == kb;
+    ok = ok && fwrite(zero,1,keys_bytes(w.hdr) - kb,w.file) == keys_bytes(w.hdr) - kb;
+    if(!ok)
+    {
+        fclose(w.file);
+        free(w.buffer);
+        w.file = 0;
+        w.buffer = 0;
+    }
+    return ok;
+}
+
+// Cac cot trong buffer duoc dat theo block_records, khi ghi thi don lai theo n
+static bool corpus_flush(corpus_writer& w)
+{
+    if(w.n == 0) return true;
+    const corpus_header& h = w.hdr;
+    unsigned long long B = h.block_records;
+    unsigned char* d = w.buffer;
+    unsigned char* r = d + B*h.digest_len;
+    unsigned char* s = r + B*h.scalar_len;
+    unsigned char* k = s + B*h.scalar_len;
+    unsigned long long len = w.n*record_bytes(h);
+    unsigned char zero[64] = {0};
+
+    bool ok = fwrite(d,h.digest_len,w.n,w.file) == (size_t)w.n;
+    ok = ok && fwrite(r,h.scalar_len,w.n,w.file) == (size_t)w.n;
+    ok = ok && fwrite(s,h.scalar_len,w.n,w.file) == (size_t)w.n;
+    ok = ok && fwrite(k,4,w.n,w.file) == (size_t)w.n;
+    ok = ok && fwrite(zero,1,pad64(len) - len,w.file) == pad64(len) - len;
+    w.n = 0;
+    return ok;
+}
+
+bool corpus_append(corpus_writer& w,const unsigned char* digest,const unsigned char* r,
+                   const unsigned char* s,unsigned long key_idx)
+{
+    const corpus_header& h = w.hdr;
+    unsigned long long B = h.block_records;
+    unsigned char* d = w.buffer;
+    memcpy(d + w.n*h.digest_len,digest,h.digest_len);
+    memcpy(d + B*h.digest_len + w.n*h.scalar_len,r,h.scalar_len);
+    memcpy(d + B*(h.digest_len + h.scalar_len) + w.n*h.scalar_len,s,h.scalar_len);
+    conv_ull_to_le(d + B*(h.digest_len + 2*h.scalar_len) + 4*w.n,key_idx,4);
+    w.n++;
+    w.hdr.record_count++;
+    if(w.n == (long)B) return corpus_flush(w);
+    return true;
+}
+
+bool corpus_finish(corpus_writer& w)
+{
+    bool ok = corpus_flush(w);
+    unsigned char count[8];
+    conv_ull_to_le(count,w.hdr.record_count,8);
+    ok = ok && fseek(w.file,40,SEEK_SET) == 0;
+    ok = ok && fwrite(count,1,8,w.file) == 8;
+    ok = (fclose(w.file) == 0) && ok;
+    free(w.buffer);
+    w.file = 0;
+    w.buffer = 0;
+    return ok;
+}
+
+static bool all_zero(const unsigned char* b,long n)
+{
+    for(long i = 0; i < n; i++)
+        if(b[i]) return false;
+    return true;
+}
+
+corpus_status verify_corpus(const char* path,unsigned long long& valid,unsigned long long& invalid,
+                            unsigned long long* bad,long maxBad)
+{
+    valid = 0;
+    invalid = 0;
+    corpus_reader rd;
+    if(!corpus_open(rd,path)) return CORPUS_BAD;
+
+    const corpus_header& h = rd.hdr;
+    long fs = field_size(E);
+    if((long)h.point_len != 2*fs || (long)h.scalar_len != scalar_size(E))
+    {
+        corpus_close(rd);
+        return CORPUS_BAD;
+    }
+    // cac duong cong cung kich thuoc (P-256, secp256k1, brainpoolP256r1) chi phan
+    // biet duoc qua dau van tay; kho cu (toan 0) thi bo qua kiem tra
+    if(curve_active && !all_zero(h.curve_id,CORPUS_CURVE_ID_LENGTH)
+       && memcmp(h.curve_id,curve_active->fingerprint,CORPUS_CURVE_ID_LENGTH) != 0)
+    {
+        corpus_close(rd);
+        return CORPUS_WRONG_CURVE;
+    }
+
+    // giai ma bang khoa mot lan, khoa khong nam tren duong cong bi danh dau
+    vector<point> keys(h.key_count);
+    vector<bool> keyOk(h.key_count);
+    for(unsigned long long i = 0; i < h.key_count; i++)
+    {
+        decode_point(keys[i],corpus_key(rd,i),fs);
+        keyOk[i] = is_on_curve(keys[i],E);
+    }
+
+    // xac thuc ca khoi mot lan (ecdsa_verify_batch), ban ghi co khoa hong bo qua
+    corpus_block blk;
+    vector<point> Q;
+    vector<signature> sg;
+    vector<ZZ> m;
+    vector<long> pos;
+    bool* ok = new bool[h.block_records];
+    unsigned long long index = 0;
+    long nbad = 0;
+    while(corpus_next_block(rd,blk))
+    {
+        Q.resize(blk.n);
+        sg.resize(blk.n);
+        m.resize(blk.n);
+        pos.assign(blk.n,-1);
+        long c = 0;
+        for(long i = 0; i < blk.n; i++)
+        {
+            unsigned long k = corpus_key_index(blk,i);
+            if(k >= h.key_count || !keyOk[k]) continue;
+            Q[c] = keys[k];
+            bits2int(m[c],blk.digests + i*h.digest_len,h.digest_len,E.n);
+            decode_scalar(sg[c].r,blk.r + i*h.scalar_len,h.scalar_len);
+            decode_scalar(sg[c].s,blk.s + i*h.scalar_len,h.scalar_len);
+            pos[i] = c++;
+        }
+        if(c) ecdsa_verify_batch(ok,&Q[0],&sg[0],&m[0],c);
+        for(long i = 0; i < blk.n; i++,index++)
+        {
+            if(pos[i] >= 0 && ok[pos[i]]) valid++;
+            else
+            {
+                invalid++;
+                if(nbad < maxBad) bad[nbad++] = index;
+            }
+        }
+    }
+    delete[] ok;
+    bool complete = rd.done == h.record_count;
+    corpus_close(rd);
+    return complete ? CORPUS_OK : CORPUS_BAD;
+}
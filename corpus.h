@@ -0,0 +1,97 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <cstdio>
+#include "ecc.h"
+#include "mapfile.h"
+
+// Kho chu ky dang cot (columnar) de xac thuc hang loat.
+//
+//   header 64 byte (little-endian):
+//     0  "ECDSAVC1"         8  version        12 digest_len    16 scalar_len
+//     20 point_len          24 block_records  32 key_count     40 record_count
+//     48 16 byte dau cua dau van tay duong cong (0 = khong ro)
+//   bang khoa: key_count * point_len byte (X || Y), can le 64
+//   cac khoi, moi khoi n <= block_records ban ghi:
+//     digest[n*digest_len] | r[n*scalar_len] | s[n*scalar_len] | key_idx[n] (u32)
+//     can le 64
+//
+// Vi tri moi khoi tinh duoc tu header, nen doc bang mmap khong can syscall
+// cho tung ban ghi; khi doc tu pipe thi doc lan luot tung khoi.
+
+#define CORPUS_VERSION 1
+#define CORPUS_BLOCK_RECORDS 4096
+#define CORPUS_MAX_BLOCK_RECORDS (1 << 20)
+#define CORPUS_CURVE_ID_LENGTH 16
+
+struct corpus_header_s
+{
+    unsigned int digest_len;
+    unsigned int scalar_len;
+    unsigned int point_len;
+    unsigned int block_records;
+    unsigned long long key_count;
+    unsigned long long record_count;
+    unsigned char curve_id[CORPUS_CURVE_ID_LENGTH];
+};
+
+typedef struct corpus_header_s corpus_header;
+
+struct corpus_block_s
+{
+    long n;
+    const unsigned char* digests;
+    const unsigned char* r;
+    const unsigned char* s;
+    const unsigned char* key_idx;
+};
+
+typedef struct corpus_block_s corpus_block;
+
+struct corpus_reader_s
+{
+    corpus_header hdr;
+    mapped_file map;
+    FILE* stream;
+    const unsigned char* keys;
+    unsigned char* key_buffer;
+    unsigned char* buffer;
+    unsigned long long pos;
+    unsigned long long done;
+};
+
+typedef struct corpus_reader_s corpus_reader;
+
+struct corpus_writer_s
+{
+    corpus_header hdr;
+    FILE* file;
+    unsigned char* buffer;
+    long n;
+};
+
+typedef struct corpus_writer_s corpus_writer;
+
+bool corpus_open(corpus_reader& rd,const char* path);
+bool corpus_next_block(corpus_reader& rd,corpus_block& blk);
+const unsigned char* corpus_key(const corpus_reader& rd,unsigned long long i);
+unsigned long corpus_key_index(const corpus_block& blk,long i);
+void corpus_close(corpus_reader& rd);
+
+// curve_id (co the 0): dau van tay duong cong, chi luu CORPUS_CURVE_ID_LENGTH byte dau
+bool corpus_create(corpus_writer& w,const char* path,unsigned int digest_len,unsigned int scalar_len,
+                   unsigned int point_len,const unsigned char* keys,unsigned long long key_count,
+                   const unsigned char* curve_id);
+bool corpus_append(corpus_writer& w,const unsigned char* digest,const unsigned char* r,
+                   const unsigned char* s,unsigned long key_idx);
+bool corpus_finish(corpus_writer& w);
+
+enum corpus_status { CORPUS_OK, CORPUS_BAD, CORPUS_WRONG_CURVE };
+
+// Xac thuc toan bo kho voi duong cong E hien tai. Tra ve CORPUS_BAD neu kho khong
+// doc duoc, CORPUS_WRONG_CURVE neu kho tao cho duong cong khac; bad nhan so thu
+// tu cac ban ghi khong hop le (toi da maxBad)
+corpus_status verify_corpus(const char* path,unsigned long long& valid,unsigned long long& invalid,
+                   unsigned long long* bad,long maxBad);
+
+#endif
@@ -0,0 +1,73 @@
+#include <cstring>
+#include "cpu.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define CPU_X86 1
+#endif
+
+static cpu_level level_limit = CPU_AVX512_IFMA;
+
+#ifdef CPU_X86
+// XCR0: trang thai thanh ghi ma he dieu hanh luu khi doi ngu canh
+static unsigned long long xgetbv0()
+{
+    unsigned int lo,hi;
+    __asm__ volatile("xgetbv" : "=a"(lo),"=d"(hi) : "c"(0));
+    return ((unsigned long long)hi << 32) | lo;
+}
+#endif
+
+cpu_level cpu_detect()
+{
+#ifdef CPU_X86
+    unsigned int eax,ebx,ecx,edx;
+    if(__get_cpuid_max(0,0) < 7) return CPU_GENERIC;
+    __cpuid(1,eax,ebx,ecx,edx);
+    bool osxsave = (ecx >> 27) & 1;
+    __cpuid_count(7,0,eax,ebx,ecx,edx);
+    bool bmi2 = (ebx >> 8) & 1;
+    bool adx = (ebx >> 19) & 1;
+    bool avx512f = (ebx >> 16) & 1;
+    bool ifma = (ebx >> 21) & 1;
+    if(!bmi2 || !adx) return CPU_GENERIC;
+    // SSE, AVX, opmask, ZMM_Hi256, Hi16_ZMM
+    if(osxsave && avx512f && ifma && (xgetbv0() & 0xe6) == 0xe6) return CPU_AVX512_IFMA;
+    return CPU_BMI2_ADX;
+#else
+    return CPU_GENERIC;
+#endif
+}
+
+cpu_level cpu_features()
+{
+    static const cpu_level detected = cpu_detect();
+    return detected < level_limit ? detected : level_limit;
+}
+
+void cpu_limit(cpu_level level)
+{
+    level_limit = level;
+}
+
+const char* cpu_level_name(cpu_level level)
+{
+    switch(level){
+        case CPU_BMI2_ADX: return "adx";
+        case CPU_AVX512_IFMA: return "ifma";
+        default: return "generic";
+    }
+}
+
+bool cpu_level_from_name(const char* name,cpu_level& level)
+{
+    for(int i = CPU_GENERIC; i <= CPU_AVX512_IFMA; i++)
+    {
+        if(strcmp(name,cpu_level_name((cpu_level)i)) == 0)
+        {
+            level = (cpu_level)i;
+            return true;
+        }
+    }
+    return false;
+}
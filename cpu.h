@@ -0,0 +1,23 @@
+#ifndef CPU_H
+#define CPU_H
+
+// Tap lenh dung cho cac kernel so hoc, phat hien bang CPUID mot lan khi khoi
+// dong; ham tinh toan chon ban kernel o lop ngoai cung, khong re nhanh trong vong lap.
+
+enum cpu_level
+{
+    CPU_GENERIC = 0,
+    CPU_BMI2_ADX,       // mulx, adcx, adox
+    CPU_AVX512_IFMA     // them AVX-512F + IFMA (vpmadd52luq/huq), he dieu hanh luu thanh ghi zmm
+};
+
+cpu_level cpu_detect();
+// muc dang dung: cpu_detect() gioi han boi cpu_limit
+cpu_level cpu_features();
+// ha muc toi da (tuy chon -cpu), goi truoc khi load duong cong
+void cpu_limit(cpu_level level);
+
+const char* cpu_level_name(cpu_level level);
+bool cpu_level_from_name(const char* name,cpu_level& level);
+
+#endif
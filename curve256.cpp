@@ -0,0 +1,623 @@
+#include <NTL/ZZ.h>
+#include <cstdlib>
+#include <cstring>
+#include "convert.h"
+#include "cpu.h"
+#include "curve256.h"
+#include "simd256.h"
+
+using namespace NTL;
+
+#ifdef CURVE256_FAST
+
+constexpr limb_t P256Params::p[4];
+constexpr limb_t P256Params::a[4];
+constexpr limb_t P256Params::b[4];
+constexpr limb_t P256Params::gx[4];
+constexpr limb_t P256Params::gy[4];
+constexpr limb_t P256Params::n[4];
+constexpr limb_t P256Params::r2[4];
+constexpr limb_t P256Params::p_inv;
+constexpr limb_t K256Params::p[4];
+constexpr limb_t K256Params::a[4];
+constexpr limb_t K256Params::b[4];
+constexpr limb_t K256Params::gx[4];
+constexpr limb_t K256Params::gy[4];
+constexpr limb_t K256Params::n[4];
+constexpr limb_t K256Params::r2[4];
+constexpr limb_t K256Params::p_inv;
+constexpr limb_t K256Params::beta[4];
+constexpr limb_t K256Params::lambda[4];
+constexpr limb_t K256Params::a1[4];
+constexpr limb_t K256Params::minus_b1[4];
+constexpr limb_t K256Params::a2[4];
+
+// beta, lambda da duoc kiem tra voi duong cong vua load
+static bool k256_glv = false;
+// kernel nhan chon theo CPU khi load duong cong
+static cpu_level kernel_level = CPU_GENERIC;
+
+static void ZZ_to_limbs(limb_t* r,const ZZ& a)
+{
+    unsigned char buf[32];
+    BytesFromZZ(buf,a,32);
+    for(int i = 0; i < 4; i++) r[i] = conv_le_to_ull(buf + 8*i,8);
+}
+
+static void limbs_to_ZZ(ZZ& r,const limb_t* a)
+{
+    unsigned char buf[32];
+    for(int i = 0; i < 4; i++) conv_ull_to_le(buf + 8*i,a[i],8);
+    ZZFromBytes(r,buf,32);
+}
+
+template<class P>
+static bool params_match(const curve& E)
+{
+    ZZ t;
+    limbs_to_ZZ(t,P::p);
+    if(E.p != t) return false;
+    limbs_to_ZZ(t,P::a);
+    if(E.a % E.p != t) return false;
+    limbs_to_ZZ(t,P::b);
+    if(E.b % E.p != t) return false;
+    limbs_to_ZZ(t,P::gx);
+    if(E.G.x != t) return false;
+    limbs_to_ZZ(t,P::gy);
+    if(E.G.y != t) return false;
+    limbs_to_ZZ(t,P::n);
+    return E.n == t;
+}
+
+template<class P,template<class> class K>
+static void to_jpoint(curve256_jpoint& r,const point& b)
+{
+    limb_t x[4],y[4];
+    ZZ_to_limbs(x,b.x);
+    ZZ_to_limbs(y,b.y);
+    Curve<P,K>::from_affine(r,x,y);
+}
+
+template<class P,template<class> class K>
+static void from_jpoint(point& a,const curve256_jpoint& r)
+{
+    limb_t x[4],y[4];
+    a.inf = !Curve<P,K>::to_affine(x,y,r);
+    if(!a.inf)
+    {
+        limbs_to_ZZ(a.x,x);
+        limbs_to_ZZ(a.y,y);
+    }
+}
+
+typedef curve256_apoint window[15];
+
+// T[j-1] = j*b
+template<class P,template<class> class K>
+static void point_window(window& T,const point& b)
+{
+    curve256_jpoint B;
+    to_jpoint<P,K>(B,b);
+    Curve<P,K>::window_tables(&T,&B,1);
+}
+
+struct key_entry
+{
+    bool used;
+    limb_t x[4];
+    limb_t y[4];
+    window T;
+};
+
+// Bang cua so cua khoa cong khai Q, lay tu bo nho dem (anh xa truc tiep theo Qx) neu co
+template<class P,template<class> class K>
+static const curve256_apoint* key_window(const point& Q)
+{
+    static thread_local key_entry cache[CURVE256_KEY_CACHE];
+    limb_t x[4],y[4];
+    ZZ_to_limbs(x,Q.x);
+    ZZ_to_limbs(y,Q.y);
+    key_entry& e = cache[x[0] & (CURVE256_KEY_CACHE - 1)];
+    if(!e.used || memcmp(e.x,x,sizeof(x)) != 0 || memcmp(e.y,y,sizeof(y)) != 0)
+    {
+        point_window<P,K>(e.T,Q);
+        memcpy(e.x,x,sizeof(x));
+        memcpy(e.y,y,sizeof(y));
+        e.used = true;
+    }
+    return e.T;
+}
+
+template<class P>
+static void reduce_scalar(limb_t* e,const ZZ& k)
+{
+    ZZ n;
+    limbs_to_ZZ(n,P::n);
+    ZZ_to_limbs(e,k % n);
+}
+
+// a = k*b
+template<class P,template<class> class K>
+static void multi_point_fixed(point& a,const ZZ& k,const point& b)
+{
+    limb_t e[4];
+    curve256_jpoint B,R;
+    reduce_scalar<P>(e,k);
+    to_jpoint<P,K>(B,b);
+    Curve<P,K>::scalar_mul(R,e,B);
+    from_jpoint<P,K>(a,R);
+}
+
+template<class P,template<class> class K>
+static void G_jac(curve256_jpoint& R,const ZZ& k)
+{
+    limb_t e[4];
+    reduce_scalar<P>(e,k);
+    Curve<P,K>::mul_g(R,e);
+}
+
+template<class P,template<class> class K>
+static void multi_point_G_fixed(point& a,const ZZ& k)
+{
+    curve256_jpoint R;
+    G_jac<P,K>(R,k);
+    from_jpoint<P,K>(a,R);
+}
+
+// R = k1*G + k2*Q
+template<class P,template<class> class K>
+static void GQ_jac(curve256_jpoint& R,const ZZ& k1,const ZZ& k2,const point& Q)
+{
+    typedef Curve<P,K> C;
+    limb_t e[2][4];
+    const curve256_apoint* T[2] = {C::g().win,0};
+    reduce_scalar<P>(e[0],k1);
+    int m = 1;
+    if(!Q.inf)
+    {
+        reduce_scalar<P>(e[1],k2);
+        T[1] = key_window<P,K>(Q);
+        m = 2;
+    }
+    C::multi_scalar_mul(R,e,T,m);
+}
+
+template<class P,template<class> class K>
+static void multi_point_GQ_fixed(point& a,const ZZ& k1,const ZZ& k2,const point& Q)
+{
+    curve256_jpoint R;
+    GQ_jac<P,K>(R,k1,k2,Q);
+    from_jpoint<P,K>(a,R);
+}
+
+// Tach k = k1 + k2*lambda (mod n), |k1|, |k2| < 2^128:
+// c1 = round(b2*k/n), c2 = round(-b1*k/n), k1 = k - c1*a1 - c2*a2, k2 = -c1*b1 - c2*b2
+static void glv_split(ZZ& k1,ZZ& k2,const ZZ& k)
+{
+    typedef K256Params P;
+    // khoi tao mot lan, an toan khi nhieu luong cung goi
+    struct consts
+    {
+        ZZ n,a1,mb1,a2;
+        consts()
+        {
+            limbs_to_ZZ(n,P::n);
+            limbs_to_ZZ(a1,P::a1);
+            limbs_to_ZZ(mb1,P::minus_b1);
+            limbs_to_ZZ(a2,P::a2);
+        }
+    };
+    static const consts c;
+    const ZZ& n = c.n;
+    const ZZ& a1 = c.a1;
+    const ZZ& mb1 = c.mb1;
+    const ZZ& a2 = c.a2;
+    ZZ e = k % n;
+    ZZ c1 = (2*a1*e + n)/(2*n);
+    ZZ c2 = (2*mb1*e + n)/(2*n);
+    k1 = e - c1*a1 - c2*a2;
+    k2 = c1*mb1 - c2*a1;
+}
+
+// Them k*B vao danh sach Straus duoi dang k1*B + k2*phi(B) tu bang cua so W cua B:
+// phi(jB) = (beta*x, y) nen bang cua phi(B) suy ra tu W; dau cua k1, k2 chuyen
+// sang bang de hai he so deu khong am
+template<template<class> class K>
+static int glv_push(limb_t (*e)[4],window* T,int m,const ZZ& k,const curve256_apoint* W)
+{
+    typedef Curve<K256Params,K> C;
+    ZZ k1,k2;
+    glv_split(k1,k2,k);
+    limb_t beta[4];
+    C::to_mont(beta,K256Params::beta);
+    for(int j = 0; j < 15; j++)
+    {
+        T[m][j] = W[j];
+        C::mul(T[m+1][j].x,W[j].x,beta);
+        C::copy(T[m+1][j].y,W[j].y);
+        if(sign(k1) < 0) C::neg(T[m][j].y,T[m][j].y);
+        if(sign(k2) < 0) C::neg(T[m+1][j].y,T[m+1][j].y);
+    }
+    ZZ_to_limbs(e[m],abs(k1));
+    ZZ_to_limbs(e[m+1],abs(k2));
+    return m + 2;
+}
+
+template<template<class> class K>
+static void glv_finish(curve256_jpoint& R,const limb_t (*e)[4],const window* T,int m)
+{
+    const curve256_apoint* t[4];
+    for(int i = 0; i < m; i++) t[i] = T[i];
+    Curve<K256Params,K>::multi_scalar_mul(R,e,t,m);
+}
+
+// secp256k1 voi GLV: moi he so chi con ~128 bit nen so phep nhan doi giam mot nua
+template<template<class> class K>
+static void multi_point_glv(point& a,const ZZ& k,const point& b)
+{
+    limb_t e[2][4];
+    window W,T[2];
+    point_window<K256Params,K>(W,b);
+    curve256_jpoint R;
+    int m = glv_push<K>(e,T,0,k,W);
+    glv_finish<K>(R,e,T,m);
+    from_jpoint<K256Params,K>(a,R);
+}
+
+template<template<class> class K>
+static void GQ_glv_jac(curve256_jpoint& R,const ZZ& k1,const ZZ& k2,const point& Q)
+{
+    limb_t e[4][4];
+    window T[4];
+    int m = glv_push<K>(e,T,0,k1,Curve<K256Params,K>::g().win);
+    if(!Q.inf) m = glv_push<K>(e,T,m,k2,key_window<K256Params,K>(Q));
+    glv_finish<K>(R,e,T,m);
+}
+
+template<template<class> class K>
+static void multi_point_GQ_glv(point& a,const ZZ& k1,const ZZ& k2,const point& Q)
+{
+    curve256_jpoint R;
+    GQ_glv_jac<K>(R,k1,k2,Q);
+    from_jpoint<K256Params,K>(a,R);
+}
+
+// beta^3 = 1 (mod p), lambda^3 = 1 (mod n), lambda*G = (beta*Gx, Gy)
+static bool glv_check(const curve& E)
+{
+    typedef K256Params P;
+    ZZ beta,lambda;
+    limbs_to_ZZ(beta,P::beta);
+    limbs_to_ZZ(lambda,P::lambda);
+    if(!IsOne(PowerMod(beta,3,E.p)) || !IsOne(PowerMod(lambda,3,E.n))) return false;
+    point L;
+    multi_point_fixed<P,kernel_generic>(L,lambda,E.G);
+    return !L.inf && L.x == MulMod(beta,E.G.x,E.p) && L.y == E.G.y;
+}
+
+curve256_id curve256_match(const curve& E)
+{
+    kernel_level = cpu_features();
+    if(params_match<P256Params>(E)) return CURVE256_P256;
+    if(params_match<K256Params>(E))
+    {
+        k256_glv = glv_check(E);
+        return CURVE256_K256;
+    }
+    return CURVE256_NONE;
+}
+
+template<template<class> class K>
+static bool multi_point_k(curve256_id id,point& a,const ZZ& k,const point& b)
+{
+    switch(id){
+        case CURVE256_P256:
+            multi_point_fixed<P256Params,K>(a,k,b);
+            return true;
+        case CURVE256_K256:
+            if(k256_glv) multi_point_glv<K>(a,k,b);
+            else multi_point_fixed<K256Params,K>(a,k,b);
+            return true;
+        default:
+            return false;
+    }
+}
+
+template<template<class> class K>
+static bool multi_point_G_k(curve256_id id,point& a,const ZZ& k)
+{
+    switch(id){
+        case CURVE256_P256:
+            multi_point_G_fixed<P256Params,K>(a,k);
+            return true;
+        case CURVE256_K256:
+            multi_point_G_fixed<K256Params,K>(a,k);
+            return true;
+        default:
+            return false;
+    }
+}
+
+template<template<class> class K>
+static bool multi_point_GQ_k(curve256_id id,point& a,const ZZ& k1,const ZZ& k2,const point& Q)
+{
+    switch(id){
+        case CURVE256_P256:
+            multi_point_GQ_fixed<P256Params,K>(a,k1,k2,Q);
+            return true;
+        case CURVE256_K256:
+            if(k256_glv) multi_point_GQ_glv<K>(a,k1,k2,Q);
+            else multi_point_GQ_fixed<K256Params,K>(a,k1,k2,Q);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool curve256_multi_point(curve256_id id,point& a,const ZZ& k,const point& b)
+{
+    if(b.inf)
+    {
+        a.inf = true;
+        return true;
+    }
+#ifdef CURVE256_ADX
+    if(kernel_level >= CPU_BMI2_ADX) return multi_point_k<kernel_adx>(id,a,k,b);
+#endif
+    return multi_point_k<kernel_generic>(id,a,k,b);
+}
+
+bool curve256_multi_point_G(curve256_id id,point& a,const ZZ& k)
+{
+#ifdef CURVE256_ADX
+    if(kernel_level >= CPU_BMI2_ADX) return multi_point_G_k<kernel_adx>(id,a,k);
+#endif
+    return multi_point_G_k<kernel_generic>(id,a,k);
+}
+
+bool curve256_multi_point_GQ(curve256_id id,point& a,const ZZ& k1,const ZZ& k2,const point& Q)
+{
+#ifdef CURVE256_ADX
+    if(kernel_level >= CPU_BMI2_ADX) return multi_point_GQ_k<kernel_adx>(id,a,k1,k2,Q);
+#endif
+    return multi_point_GQ_k<kernel_generic>(id,a,k1,k2,Q);
+}
+
+bool curve256_soa_alloc(curve256_soa& s,long n,int coords)
+{
+    long stride = (n + 7) & ~7L;
+    size_t limbs = 4*stride*sizeof(limb_t);
+    size_t size = coords*limbs + (coords > 1 ? stride : 0);
+    s.mem = malloc(size + 63);
+    if(!s.mem) return false;
+    unsigned char* base = (unsigned char*)(((size_t)s.mem + 63) & ~(size_t)63);
+    s.v.X = (limb_t*)base;
+    s.v.Y = coords > 1 ? (limb_t*)(base + limbs) : 0;
+    s.v.Z = coords > 2 ? (limb_t*)(base + 2*limbs) : 0;
+    s.v.inf = coords > 1 ? base + coords*limbs : 0;
+    s.v.n = n;
+    s.v.stride = stride;
+    return true;
+}
+
+void curve256_soa_free(curve256_soa& s)
+{
+    free(s.mem);
+    s.mem = 0;
+}
+
+curve256_soa_view curve256_soa_slice(const curve256_soa_view& v,long first,long n)
+{
+    curve256_soa_view r = v;
+    r.X += first;
+    if(r.Y) r.Y += first;
+    if(r.Z) r.Z += first;
+    if(r.inf) r.inf += first;
+    r.n = n;
+    return r;
+}
+
+static void soa_put_ZZ(limb_t* A,const curve256_soa_view& v,long i,const ZZ& a)
+{
+    limb_t t[4];
+    ZZ_to_limbs(t,a);
+    curve256_soa_put(A,v,i,t);
+}
+
+static void soa_get_point(point& a,const curve256_soa_view& v,long i)
+{
+    limb_t t[4];
+    a.inf = v.inf[i];
+    if(a.inf) return;
+    curve256_soa_get(t,v.X,v,i);
+    limbs_to_ZZ(a.x,t);
+    curve256_soa_get(t,v.Y,v,i);
+    limbs_to_ZZ(a.y,t);
+}
+
+typedef void (*G_jac_fn)(curve256_jpoint&,const ZZ&);
+typedef void (*GQ_jac_fn)(curve256_jpoint&,const ZZ&,const ZZ&,const point&);
+
+// Cac phan tu idx[0..m) cua lo tinh bang ban vo huong vao lo Jacobian, roi ve
+// affine trong R voi mot phep nghich dao chung
+template<class P,template<class> class K>
+static bool batch_scalar(const curve256_soa_view& R,const long* idx,long m,G_jac_fn g,GQ_jac_fn gq,
+                         const ZZ* k1,const ZZ* k2,const point* Q)
+{
+    curve256_soa J,A;
+    if(!curve256_soa_alloc(J,m,CURVE256_SOA_JACOBIAN)) return false;
+    if(!curve256_soa_alloc(A,m,CURVE256_SOA_AFFINE))
+    {
+        curve256_soa_free(J);
+        return false;
+    }
+    curve256_jpoint T;
+    for(long j = 0; j < m; j++)
+    {
+        long i = idx[j];
+        if(g) g(T,k1[i]);
+        else gq(T,k1[i],k2[i],Q[i]);
+        Curve<P,K>::soa_put(J.v,j,T);
+    }
+    Curve<P,K>::batch_to_affine(A.v,J.v);
+    limb_t t[4];
+    for(long j = 0; j < m; j++)
+    {
+        long i = idx[j];
+        R.inf[i] = A.v.inf[j];
+        curve256_soa_get(t,A.v.X,A.v,j);
+        curve256_soa_put(R.X,R,i,t);
+        curve256_soa_get(t,A.v.Y,A.v,j);
+        curve256_soa_put(R.Y,R,i,t);
+    }
+    curve256_soa_free(J);
+    curve256_soa_free(A);
+    return true;
+}
+
+// a[i] = k1[i]*G (+ k2[i]*Q[i] neu gq): ket qua tinh trong lo affine R dang cot.
+// Co AVX-512 IFMA thi tinh 8 phan tu mot luc tu lo so vo huong va lo Q; phan tu
+// gap truong hop dac biet cua phep cong (va ca lo neu khong co IFMA) di ban vo huong.
+template<class P,template<class> class K>
+static bool batch_mul(point* a,long count,G_jac_fn g,GQ_jac_fn gq,const ZZ* k1,const ZZ* k2,const point* Q)
+{
+    if(count <= 0) return true;
+    curve256_soa R;
+    if(!curve256_soa_alloc(R,count,CURVE256_SOA_AFFINE)) return false;
+    std::vector<long> redo;
+    bool ok = true;
+#ifdef SIMD256
+    if(kernel_level >= CPU_AVX512_IFMA)
+    {
+        curve256_soa S1,S2,QS;
+        S2.mem = QS.mem = 0;
+        ok = curve256_soa_alloc(S1,count,CURVE256_SOA_SCALAR);
+        ok = ok && (g || (curve256_soa_alloc(S2,count,CURVE256_SOA_SCALAR)
+                          && curve256_soa_alloc(QS,count,CURVE256_SOA_AFFINE)));
+        if(ok)
+        {
+            limb_t t[4];
+            for(long i = 0; i < count; i++)
+            {
+                reduce_scalar<P>(t,k1[i]);
+                curve256_soa_put(S1.v.X,S1.v,i,t);
+                if(g) continue;
+                // Q vo cuc: tinh k1*G + 0*G
+                if(Q[i].inf)
+                {
+                    memset(t,0,sizeof(t));
+                    curve256_soa_put(S2.v.X,S2.v,i,t);
+                    curve256_soa_put(QS.v.X,QS.v,i,P::gx);
+                    curve256_soa_put(QS.v.Y,QS.v,i,P::gy);
+                    continue;
+                }
+                reduce_scalar<P>(t,k2[i]);
+                curve256_soa_put(S2.v.X,S2.v,i,t);
+                soa_put_ZZ(QS.v.X,QS.v,i,Q[i].x);
+                soa_put_ZZ(QS.v.Y,QS.v,i,Q[i].y);
+            }
+            for(long i = 0; i < count; i += SIMD256_LANES)
+            {
+                long m = count - i < SIMD256_LANES ? count - i : SIMD256_LANES;
+                curve256_soa_view r = curve256_soa_slice(R.v,i,m);
+                unsigned done;
+                if(g) done = simd256_mul_g<P>(r,curve256_soa_slice(S1.v,i,m));
+                else done = simd256_mul_gq<P>(r,curve256_soa_slice(S1.v,i,m),curve256_soa_slice(S2.v,i,m),
+                                              curve256_soa_slice(QS.v,i,m));
+                for(long j = 0; j < m; j++)
+                    if(!((done >> j) & 1)) redo.push_back(i + j);
+            }
+        }
+        if(S1.mem) curve256_soa_free(S1);
+        if(S2.mem) curve256_soa_free(S2);
+        if(QS.mem) curve256_soa_free(QS);
+    }
+    else
+#endif
+    {
+        redo.resize(count);
+        for(long i = 0; i < count; i++) redo[i] = i;
+    }
+    if(ok && !redo.empty()) ok = batch_scalar<P,K>(R.v,&redo[0],redo.size(),g,gq,k1,k2,Q);
+    if(ok)
+        for(long i = 0; i < count; i++) soa_get_point(a[i],R.v,i);
+    curve256_soa_free(R);
+    return ok;
+}
+
+template<template<class> class K>
+static bool batch_G_k(curve256_id id,point* a,const ZZ* k,long count)
+{
+    switch(id){
+        case CURVE256_P256:
+            return batch_mul<P256Params,K>(a,count,G_jac<P256Params,K>,0,k,0,0);
+        case CURVE256_K256:
+            return batch_mul<K256Params,K>(a,count,G_jac<K256Params,K>,0,k,0,0);
+        default:
+            return false;
+    }
+}
+
+template<template<class> class K>
+static bool batch_GQ_k(curve256_id id,point* a,const ZZ* k1,const ZZ* k2,const point* Q,long count)
+{
+    switch(id){
+        case CURVE256_P256:
+            return batch_mul<P256Params,K>(a,count,0,GQ_jac<P256Params,K>,k1,k2,Q);
+        case CURVE256_K256:
+            if(k256_glv) return batch_mul<K256Params,K>(a,count,0,GQ_glv_jac<K>,k1,k2,Q);
+            return batch_mul<K256Params,K>(a,count,0,GQ_jac<K256Params,K>,k1,k2,Q);
+        default:
+            return false;
+    }
+}
+
+bool curve256_batch_multi_point_G(curve256_id id,point* a,const ZZ* k,long count)
+{
+#ifdef CURVE256_ADX
+    if(kernel_level >= CPU_BMI2_ADX) return batch_G_k<kernel_adx>(id,a,k,count);
+#endif
+    return batch_G_k<kernel_generic>(id,a,k,count);
+}
+
+bool curve256_batch_multi_point_GQ(curve256_id id,point* a,const ZZ* k1,const ZZ* k2,const point* Q,long count)
+{
+#ifdef CURVE256_ADX
+    if(kernel_level >= CPU_BMI2_ADX) return batch_GQ_k<kernel_adx>(id,a,k1,k2,Q,count);
+#endif
+    return batch_GQ_k<kernel_generic>(id,a,k1,k2,Q,count);
+}
+
+#else
+
+curve256_id curve256_match(const curve& E)
+{
+    return CURVE256_NONE;
+}
+
+bool curve256_multi_point(curve256_id id,point& a,const ZZ& k,const point& b)
+{
+    return false;
+}
+
+bool curve256_multi_point_G(curve256_id id,point& a,const ZZ& k)
+{
+    return false;
+}
+
+bool curve256_multi_point_GQ(curve256_id id,point& a,const ZZ& k1,const ZZ& k2,const point& Q)
+{
+    return false;
+}
+
+bool curve256_batch_multi_point_G(curve256_id id,point* a,const ZZ* k,long count)
+{
+    return false;
+}
+
+bool curve256_batch_multi_point_GQ(curve256_id id,point* a,const ZZ* k1,const ZZ* k2,const point* Q,long count)
+{
+    return false;
+}
+
+#endif
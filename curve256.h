@@ -0,0 +1,867 @@
+#ifndef CURVE256_H
+#define CURVE256_H
+
+#include <vector>
+#include "ecc.h"
+
+// Duong cong 256 bit co tham so biet luc bien dich (P-256, secp256k1).
+// Curve<Params> lam viec tren 4 limb 64 bit dang Montgomery, diem dang
+// Jacobian; p, a, b, G, n la mang constexpr nen vong lap rut gon duoc trai
+// ra va hang so duoc gap lai. Bang tinh san (cua G, cua khoa cong khai) luu o
+// dang affine de vong lap chi dung phep cong hon hop. Can kieu 128 bit (__int128), neu khong co thi
+// curve256_multi_point tra ve false va chuong trinh dung duong ZZ chung.
+
+enum curve256_id
+{
+    CURVE256_NONE = 0,
+    CURVE256_P256,
+    CURVE256_K256
+};
+
+// So tham so E voi cac duong cong bien dich san
+curve256_id curve256_match(const curve& E);
+// a = kB, B phai nam tren duong cong id
+bool curve256_multi_point(curve256_id id,point& a,const ZZ& k,const point& b);
+// a = kG bang comb tinh mot lan
+bool curve256_multi_point_G(curve256_id id,point& a,const ZZ& k);
+// a = k1*G + k2*Q, dung chung cac phep nhan doi; bang cua Q duoc giu lai trong
+// bo nho dem theo luong de kiem tra lai cung mot khoa nhanh hon
+bool curve256_multi_point_GQ(curve256_id id,point& a,const ZZ& k1,const ZZ& k2,const point& Q);
+// Ban hang loat: a[i] = k[i]*G va a[i] = k1[i]*G + k2[i]*Q[i] voi i < count.
+// CPU co AVX-512 IFMA thi tinh 8 phep nhan mot luc (simd256.h), neu khong thi lap
+// lai ban tung phep
+bool curve256_batch_multi_point_G(curve256_id id,point* a,const ZZ* k,long count);
+bool curve256_batch_multi_point_GQ(curve256_id id,point* a,const ZZ* k1,const ZZ* k2,const point* Q,long count);
+
+// so bang khoa cong khai giu lai moi luong, moi duong cong (luy thua cua 2)
+#define CURVE256_KEY_CACHE 16
+
+#if defined(__SIZEOF_INT128__)
+#define CURVE256_FAST 1
+
+typedef unsigned long long limb_t;
+typedef unsigned __int128 dlimb_t;
+
+// vong lap 4 limb duoc trai ra hoan toan
+#if defined(__clang__)
+#define CURVE256_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define CURVE256_UNROLL _Pragma("GCC unroll 4")
+#else
+#define CURVE256_UNROLL
+#endif
+
+// Moi mang la 4 limb little-endian
+struct P256Params
+{
+    static constexpr limb_t p[4] = {0xffffffffffffffffULL, 0x00000000ffffffffULL, 0x0000000000000000ULL, 0xffffffff00000001ULL};
+    static constexpr limb_t a[4] = {0xfffffffffffffffcULL, 0x00000000ffffffffULL, 0x0000000000000000ULL, 0xffffffff00000001ULL};
+    static constexpr limb_t b[4] = {0x3bce3c3e27d2604bULL, 0x651d06b0cc53b0f6ULL, 0xb3ebbd55769886bcULL, 0x5ac635d8aa3a93e7ULL};
+    static constexpr limb_t gx[4] = {0xf4a13945d898c296ULL, 0x77037d812deb33a0ULL, 0xf8bce6e563a440f2ULL, 0x6b17d1f2e12c4247ULL};
+    static constexpr limb_t gy[4] = {0xcbb6406837bf51f5ULL, 0x2bce33576b315eceULL, 0x8ee7eb4a7c0f9e16ULL, 0x4fe342e2fe1a7f9bULL};
+    static constexpr limb_t n[4] = {0xf3b9cac2fc632551ULL, 0xbce6faada7179e84ULL, 0xffffffffffffffffULL, 0xffffffff00000000ULL};
+    static constexpr limb_t p_inv = 0x0000000000000001ULL;     // -p^-1 mod 2^64
+    static constexpr limb_t r2[4] = {0x0000000000000003ULL, 0xfffffffbffffffffULL, 0xfffffffffffffffeULL, 0x00000004fffffffdULL}; // 2^512 mod p
+    static constexpr int a_kind = CURVE_A_MINUS_3;
+};
+
+struct K256Params
+{
+    static constexpr limb_t p[4] = {0xfffffffefffffc2fULL, 0xffffffffffffffffULL, 0xffffffffffffffffULL, 0xffffffffffffffffULL};
+    static constexpr limb_t a[4] = {0, 0, 0, 0};
+    static constexpr limb_t b[4] = {7, 0, 0, 0};
+    static constexpr limb_t gx[4] = {0x59f2815b16f81798ULL, 0x029bfcdb2dce28d9ULL, 0x55a06295ce870b07ULL, 0x79be667ef9dcbbacULL};
+    static constexpr limb_t gy[4] = {0x9c47d08ffb10d4b8ULL, 0xfd17b448a6855419ULL, 0x5da4fbfc0e1108a8ULL, 0x483ada7726a3c465ULL};
+    static constexpr limb_t n[4] = {0xbfd25e8cd0364141ULL, 0xbaaedce6af48a03bULL, 0xfffffffffffffffeULL, 0xffffffffffffffffULL};
+    static constexpr limb_t p_inv = 0xd838091dd2253531ULL;
+    static constexpr limb_t r2[4] = {0x000007a2000e90a1ULL, 0x0000000000000001ULL, 0, 0};
+    static constexpr int a_kind = CURVE_A_ZERO;
+    // Tu dong cau GLV: phi(x,y) = (beta*x, y) = lambda*(x,y)
+    static constexpr limb_t beta[4] = {0xc1396c28719501eeULL, 0x9cf0497512f58995ULL, 0x6e64479eac3434e9ULL, 0x7ae96a2b657c0710ULL};
+    static constexpr limb_t lambda[4] = {0xdf02967c1b23bd72ULL, 0x122e22ea20816678ULL, 0xa5261c028812645aULL, 0x5363ad4cc05c30e0ULL};
+    // co so luoi tach k: (a1, b1), (a2, b2) voi b1 = -minus_b1, b2 = a1
+    static constexpr limb_t a1[4] = {0xe86c90e49284eb15ULL, 0x3086d221a7d46bcdULL, 0, 0};
+    static constexpr limb_t minus_b1[4] = {0x6f547fa90abfe4c3ULL, 0xe4437ed6010e8828ULL, 0, 0};
+    static constexpr limb_t a2[4] = {0x57c1108d9d44cfd8ULL, 0x14ca50f7a8e2f3f6ULL, 0x0000000000000001ULL, 0};
+};
+
+// Diem Jacobian (X/Z^2, Y/Z^3) dang Montgomery, Z = 0 la diem vo cuc
+struct curve256_jpoint
+{
+    limb_t X[4];
+    limb_t Y[4];
+    limb_t Z[4];
+};
+
+// Diem affine dang Montgomery cua bang tinh san, khong bieu dien diem vo cuc
+struct curve256_apoint
+{
+    limb_t x[4];
+    limb_t y[4];
+};
+
+// Lo diem / so vo huong dang cot (SoA) cho cac ham hang loat: limb q cua phan tu i
+// nam o X[q*stride + i], nen cung mot limb cua cac phan tu lien tiep nam lien nhau
+// (8 phan tu = mot dong cache 64 byte = mot thanh ghi zmm) va vong lap doc thang
+// ma khong phai theo con tro nhu mang point. Lo so vo huong chi dung X; lo diem
+// Jacobian dung Z = 0 cho diem vo cuc, lo affine dung inf.
+struct curve256_soa_view
+{
+    limb_t* X;
+    limb_t* Y;
+    limb_t* Z;
+    unsigned char* inf;
+    long n;
+    long stride;
+};
+
+// Bo nho cua mot lo: stride la boi cua 8, moi mang bat dau o dau dong cache
+struct curve256_soa
+{
+    void* mem;
+    curve256_soa_view v;
+};
+
+#define CURVE256_SOA_SCALAR 1
+#define CURVE256_SOA_AFFINE 2
+#define CURVE256_SOA_JACOBIAN 3
+
+// coords: CURVE256_SOA_SCALAR (X), _AFFINE (X, Y, inf), _JACOBIAN (X, Y, Z, inf)
+bool curve256_soa_alloc(curve256_soa& s,long n,int coords);
+void curve256_soa_free(curve256_soa& s);
+// lo con [first, first + n), dung chung bo nho voi v
+curve256_soa_view curve256_soa_slice(const curve256_soa_view& v,long first,long n);
+
+inline void curve256_soa_get(limb_t* r,const limb_t* A,const curve256_soa_view& v,long i)
+{
+    for(int q = 0; q < 4; q++) r[q] = A[q*v.stride + i];
+}
+
+inline void curve256_soa_put(limb_t* A,const curve256_soa_view& v,long i,const limb_t* a)
+{
+    for(int q = 0; q < 4; q++) A[q*v.stride + i] = a[q];
+}
+
+// r = t - p neu t (5 limb) >= p, nguoc lai r = t
+template<class P>
+inline void curve256_reduce_once(limb_t* r,const limb_t* t,limb_t hi)
+{
+    limb_t d[4];
+    limb_t borrow = 0;
+    CURVE256_UNROLL
+    for(int i = 0; i < 4; i++)
+    {
+        dlimb_t s = (dlimb_t)t[i] - P::p[i] - borrow;
+        d[i] = (limb_t)s;
+        borrow = (limb_t)(s >> 64) & 1;
+    }
+    bool sub = hi != 0 || borrow == 0;
+    CURVE256_UNROLL
+    for(int i = 0; i < 4; i++) r[i] = sub ? d[i] : t[i];
+}
+
+// Kernel nhan Montgomery r = a*b/2^256 mod p. Curve<P, K> goi K<P>::mul, K<P>::sqr
+// truc tiep; viec chon kernel theo CPU lam mot lan o ham ngoai cung (curve256.cpp).
+template<class P>
+struct kernel_generic
+{
+    // CIOS
+    static void mul(limb_t* r,const limb_t* a,const limb_t* b)
+    {
+        limb_t t[6] = {0,0,0,0,0,0};
+        CURVE256_UNROLL
+        for(int i = 0; i < 4; i++)
+        {
+            limb_t carry = 0;
+            CURVE256_UNROLL
+            for(int j = 0; j < 4; j++)
+            {
+                dlimb_t s = (dlimb_t)a[j]*b[i] + t[j] + carry;
+                t[j] = (limb_t)s;
+                carry = (limb_t)(s >> 64);
+            }
+            dlimb_t s = (dlimb_t)t[4] + carry;
+            t[4] = (limb_t)s;
+            t[5] = (limb_t)(s >> 64);
+
+            limb_t m = t[0]*P::p_inv;
+            s = (dlimb_t)m*P::p[0] + t[0];
+            carry = (limb_t)(s >> 64);
+            CURVE256_UNROLL
+            for(int j = 1; j < 4; j++)
+            {
+                s = (dlimb_t)m*P::p[j] + t[j] + carry;
+                t[j-1] = (limb_t)s;
+                carry = (limb_t)(s >> 64);
+            }
+            s = (dlimb_t)t[4] + carry;
+            t[3] = (limb_t)s;
+            t[4] = t[5] + (limb_t)(s >> 64);
+        }
+        curve256_reduce_once<P>(r,t,t[4]);
+    }
+
+    static void sqr(limb_t* r,const limb_t* a)
+    {
+        mul(r,a,a);
+    }
+};
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CURVE256_ADX 1
+
+// Mot hang CIOS: t += a_i*b roi t = (t + m*p)/2^64. mulx khong dung co, adcx chi
+// dung CF (chuoi phan thap), adox chi dung OF (chuoi phan cao) nen hai chuoi nho
+// chay song song.
+#define CURVE256_ADX_ROW(off) \
+    "movq " #off "(%[a]), %%rdx\n\t" \
+    "xorl %k[z], %k[z]\n\t" \
+    "mulxq 0(%[b]), %[lo], %[hi]\n\t" \
+    "adcxq %[lo], %[t0]\n\t" \
+    "adoxq %[hi], %[t1]\n\t" \
+    "mulxq 8(%[b]), %[lo], %[hi]\n\t" \
+    "adcxq %[lo], %[t1]\n\t" \
+    "adoxq %[hi], %[t2]\n\t" \
+    "mulxq 16(%[b]), %[lo], %[hi]\n\t" \
+    "adcxq %[lo], %[t2]\n\t" \
+    "adoxq %[hi], %[t3]\n\t" \
+    "mulxq 24(%[b]), %[lo], %[hi]\n\t" \
+    "adcxq %[lo], %[t3]\n\t" \
+    "adoxq %[hi], %[t4]\n\t" \
+    "movq %[z], %[t5]\n\t" \
+    "adcxq %[z], %[t4]\n\t" \
+    "adcxq %[z], %[t5]\n\t" \
+    "adoxq %[z], %[t5]\n\t" \
+    "movq %[t0], %%rdx\n\t" \
+    "imulq %[pinv], %%rdx\n\t" \
+    "xorl %k[z], %k[z]\n\t" \
+    "mulxq %[p0], %[lo], %[hi]\n\t" \
+    "adcxq %[lo], %[t0]\n\t" \
+    "adoxq %[hi], %[t1]\n\t" \
+    "mulxq %[p1], %[lo], %[hi]\n\t" \
+    "adcxq %[lo], %[t1]\n\t" \
+    "adoxq %[hi], %[t2]\n\t" \
+    "mulxq %[p2], %[lo], %[hi]\n\t" \
+    "adcxq %[lo], %[t2]\n\t" \
+    "adoxq %[hi], %[t3]\n\t" \
+    "mulxq %[p3], %[lo], %[hi]\n\t" \
+    "adcxq %[lo], %[t3]\n\t" \
+    "adoxq %[hi], %[t4]\n\t" \
+    "adcxq %[z], %[t4]\n\t" \
+    "adcxq %[z], %[t5]\n\t" \
+    "adoxq %[z], %[t5]\n\t" \
+    "movq %[t1], %[t0]\n\t" \
+    "movq %[t2], %[t1]\n\t" \
+    "movq %[t3], %[t2]\n\t" \
+    "movq %[t4], %[t3]\n\t" \
+    "movq %[t5], %[t4]\n\t"
+
+// Mot vong rut gon SOS: x0 += m*p (x0 ve 0), x4 nhan them nho cua vong truoc (giu
+// trong t0, bang 0 o vong dau vi t0 vua ve 0), nho moi (0..2) ghi lai vao t0.
+#define CURVE256_ADX_REDC(x0,x1,x2,x3,x4) \
+    "movq %[" #x0 "], %%rdx\n\t" \
+    "imulq %[pinv], %%rdx\n\t" \
+    "xorl %k[z], %k[z]\n\t" \
+    "mulxq %[p0], %[lo], %[hi]\n\t" \
+    "adcxq %[lo], %[" #x0 "]\n\t" \
+    "adoxq %[hi], %[" #x1 "]\n\t" \
+    "mulxq %[p1], %[lo], %[hi]\n\t" \
+    "adcxq %[lo], %[" #x1 "]\n\t" \
+    "adoxq %[hi], %[" #x2 "]\n\t" \
+    "mulxq %[p2], %[lo], %[hi]\n\t" \
+    "adcxq %[lo], %[" #x2 "]\n\t" \
+    "adoxq %[hi], %[" #x3 "]\n\t" \
+    "mulxq %[p3], %[lo], %[hi]\n\t" \
+    "adcxq %[lo], %[" #x3 "]\n\t" \
+    "adoxq %[hi], %[" #x4 "]\n\t" \
+    "adcxq %[t0], %[" #x4 "]\n\t" \
+    "movq %[z], %[t0]\n\t" \
+    "adcxq %[z], %[t0]\n\t" \
+    "adoxq %[z], %[t0]\n\t"
+
+// BMI2 + ADX (Broadwell tro di). Lenh viet bang asm noi tuyen nen khong can
+// bien dich ca chuong trinh voi -mbmi2 -madx; chi duoc goi khi cpu_features() cho phep.
+template<class P>
+struct kernel_adx
+{
+    static void mul(limb_t* r,const limb_t* a,const limb_t* b)
+    {
+        limb_t t[5],t5,lo,hi,z;
+        __asm__(
+            "xorl %k[t0], %k[t0]\n\t"
+            "xorl %k[t1], %k[t1]\n\t"
+            "xorl %k[t2], %k[t2]\n\t"
+            "xorl %k[t3], %k[t3]\n\t"
+            "xorl %k[t4], %k[t4]\n\t"
+            CURVE256_ADX_ROW(0)
+            CURVE256_ADX_ROW(8)
+            CURVE256_ADX_ROW(16)
+            CURVE256_ADX_ROW(24)
+            : [t0] "=&r"(t[0]),[t1] "=&r"(t[1]),[t2] "=&r"(t[2]),[t3] "=&r"(t[3]),[t4] "=&r"(t[4]),
+              [t5] "=&r"(t5),[lo] "=&r"(lo),[hi] "=&r"(hi),[z] "=&r"(z)
+            : [a] "r"(a),[b] "r"(b),[pinv] "r"(P::p_inv),
+              [p0] "m"(P::p[0]),[p1] "m"(P::p[1]),[p2] "m"(P::p[2]),[p3] "m"(P::p[3]),
+              "m"(*(const limb_t (*)[4])a),"m"(*(const limb_t (*)[4])b)
+            : "rdx","cc");
+        curve256_reduce_once<P>(r,t,t[4]);
+    }
+
+    // SOS: 6 tich cheo nhan doi + 4 binh phuong tren duong cheo (10 mulx thay vi
+    // 16), roi 4 vong rut gon; nho giua cac vong giu trong t0 (da ve 0 sau vong dau)
+    static void sqr(limb_t* r,const limb_t* a)
+    {
+        limb_t t[8],lo,hi,z;
+        __asm__(
+            // tich cheo a_i*a_j (i < j) vao t1..t6
+            "movq 0(%[a]), %%rdx\n\t"
+            "xorl %k[z], %k[z]\n\t"
+            "mulxq 8(%[a]), %[t1], %[t2]\n\t"
+            "mulxq 16(%[a]), %[lo], %[t3]\n\t"
+            "adcxq %[lo], %[t2]\n\t"
+            "mulxq 24(%[a]), %[lo], %[t4]\n\t"
+            "adcxq %[lo], %[t3]\n\t"
+            "adcxq %[z], %[t4]\n\t"
+            "movq 8(%[a]), %%rdx\n\t"
+            "xorl %k[z], %k[z]\n\t"
+            "mulxq 16(%[a]), %[lo], %[hi]\n\t"
+            "adoxq %[lo], %[t3]\n\t"
+            "adcxq %[hi], %[t4]\n\t"
+            "mulxq 24(%[a]), %[lo], %[t5]\n\t"
+            "adoxq %[lo], %[t4]\n\t"
+            "adcxq %[z], %[t5]\n\t"
+            "adoxq %[z], %[t5]\n\t"
+            "movq 16(%[a]), %%rdx\n\t"
+            "xorl %k[z], %k[z]\n\t"
+            "mulxq 24(%[a]), %[lo], %[t6]\n\t"
+            "adcxq %[lo], %[t5]\n\t"
+            "adcxq %[z], %[t6]\n\t"
+            // nhan doi (CF) va cong duong cheo a_i^2 (OF)
+            "xorl %k[z], %k[z]\n\t"
+            "movq 0(%[a]), %%rdx\n\t"
+            "mulxq %%rdx, %[t0], %[hi]\n\t"
+            "adcxq %[t1], %[t1]\n\t"
+            "adoxq %[hi], %[t1]\n\t"
+            "movq 8(%[a]), %%rdx\n\t"
+            "mulxq %%rdx, %[lo], %[hi]\n\t"
+            "adcxq %[t2], %[t2]\n\t"
+            "adoxq %[lo], %[t2]\n\t"
+            "adcxq %[t3], %[t3]\n\t"
+            "adoxq %[hi], %[t3]\n\t"
+            "movq 16(%[a]), %%rdx\n\t"
+            "mulxq %%rdx, %[lo], %[hi]\n\t"
+            "adcxq %[t4], %[t4]\n\t"
+            "adoxq %[lo], %[t4]\n\t"
+            "adcxq %[t5], %[t5]\n\t"
+            "adoxq %[hi], %[t5]\n\t"
+            "movq 24(%[a]), %%rdx\n\t"
+            "mulxq %%rdx, %[lo], %[t7]\n\t"
+            "adcxq %[t6], %[t6]\n\t"
+            "adoxq %[lo], %[t6]\n\t"
+            "adcxq %[z], %[t7]\n\t"
+            "adoxq %[z], %[t7]\n\t"
+            // rut gon Montgomery
+            CURVE256_ADX_REDC(t0,t1,t2,t3,t4)
+            CURVE256_ADX_REDC(t1,t2,t3,t4,t5)
+            CURVE256_ADX_REDC(t2,t3,t4,t5,t6)
+            CURVE256_ADX_REDC(t3,t4,t5,t6,t7)
+            : [t0] "=&r"(t[0]),[t1] "=&r"(t[1]),[t2] "=&r"(t[2]),[t3] "=&r"(t[3]),
+              [t4] "=&r"(t[4]),[t5] "=&r"(t[5]),[t6] "=&r"(t[6]),[t7] "=&r"(t[7]),
+              [lo] "=&r"(lo),[hi] "=&r"(hi),[z] "=&r"(z)
+            : [a] "r"(a),[pinv] "m"(P::p_inv),
+              [p0] "m"(P::p[0]),[p1] "m"(P::p[1]),[p2] "m"(P::p[2]),[p3] "m"(P::p[3]),
+              "m"(*(const limb_t (*)[4])a)
+            : "rdx","cc");
+        curve256_reduce_once<P>(r,t + 4,t[0]);
+    }
+};
+
+#endif
+
+template<class P,template<class> class K = kernel_generic>
+struct Curve
+{
+    typedef curve256_jpoint jpoint;
+    typedef curve256_apoint apoint;
+
+    // bang cua so 4 bit: T[j-1] = j*a
+    typedef apoint window[15];
+
+    static void copy(limb_t* r,const limb_t* a)
+    {
+        CURVE256_UNROLL
+        for(int i = 0; i < 4; i++) r[i] = a[i];
+    }
+
+    static bool is_zero(const limb_t* a)
+    {
+        return (a[0] | a[1] | a[2] | a[3]) == 0;
+    }
+
+    static void reduce_once(limb_t* r,const limb_t* t,limb_t hi)
+    {
+        curve256_reduce_once<P>(r,t,hi);
+    }
+
+    static void add(limb_t* r,const limb_t* a,const limb_t* b)
+    {
+        limb_t t[4];
+        limb_t carry = 0;
+        CURVE256_UNROLL
+        for(int i = 0; i < 4; i++)
+        {
+            dlimb_t s = (dlimb_t)a[i] + b[i] + carry;
+            t[i] = (limb_t)s;
+            carry = (limb_t)(s >> 64);
+        }
+        reduce_once(r,t,carry);
+    }
+
+    static void sub(limb_t* r,const limb_t* a,const limb_t* b)
+    {
+        limb_t t[4];
+        limb_t borrow = 0;
+        CURVE256_UNROLL
+        for(int i = 0; i < 4; i++)
+        {
+            dlimb_t s = (dlimb_t)a[i] - b[i] - borrow;
+            t[i] = (limb_t)s;
+            borrow = (limb_t)(s >> 64) & 1;
+        }
+        // am thi cong lai p
+        limb_t mask = (limb_t)0 - borrow;
+        limb_t carry = 0;
+        CURVE256_UNROLL
+        for(int i = 0; i < 4; i++)
+        {
+            dlimb_t s = (dlimb_t)t[i] + (P::p[i] & mask) + carry;
+            r[i] = (limb_t)s;
+            carry = (limb_t)(s >> 64);
+        }
+    }
+
+    // r = a*b/2^256 mod p
+    static void mul(limb_t* r,const limb_t* a,const limb_t* b)
+    {
+        K<P>::mul(r,a,b);
+    }
+
+    static void neg(limb_t* r,const limb_t* a)
+    {
+        static const limb_t zero[4] = {0,0,0,0};
+        sub(r,zero,a);
+    }
+
+    static void sqr(limb_t* r,const limb_t* a)
+    {
+        K<P>::sqr(r,a);
+    }
+
+    static void to_mont(limb_t* r,const limb_t* a)
+    {
+        mul(r,a,P::r2);
+    }
+
+    static void from_mont(limb_t* r,const limb_t* a)
+    {
+        static const limb_t one[4] = {1,0,0,0};
+        mul(r,a,one);
+    }
+
+    // r = a^(p-2) = a^-1 (Fermat)
+    static void inv(limb_t* r,const limb_t* a)
+    {
+        static const limb_t one[4] = {1,0,0,0};
+        limb_t e[4] = {P::p[0] - 2,P::p[1],P::p[2],P::p[3]};
+        limb_t x[4];
+        to_mont(x,one);
+        for(int i = 255; i >= 0; i--)
+        {
+            sqr(x,x);
+            if((e[i/64] >> (i%64)) & 1) mul(x,x,a);
+        }
+        copy(r,x);
+    }
+
+    static void set_inf(jpoint& r)
+    {
+        CURVE256_UNROLL
+        for(int i = 0; i < 4; i++) r.X[i] = r.Y[i] = r.Z[i] = 0;
+    }
+
+    static void dbl(jpoint& r,const jpoint& a)
+    {
+        if(is_zero(a.Z))
+        {
+            r = a;
+            return;
+        }
+        limb_t X3[4],Y3[4],Z3[4],t1[4],t2[4],t3[4];
+        if(P::a_kind == CURVE_A_MINUS_3)
+        {
+            // dbl-2001-b: alpha = 3(X - Z^2)(X + Z^2)
+            limb_t delta[4],gamma[4],beta[4],alpha[4];
+            sqr(delta,a.Z);
+            sqr(gamma,a.Y);
+            mul(beta,a.X,gamma);
+            sub(t1,a.X,delta);
+            add(t2,a.X,delta);
+            mul(t3,t1,t2);
+            add(alpha,t3,t3);
+            add(alpha,alpha,t3);
+            sqr(X3,alpha);
+            add(t1,beta,beta);          // 2 beta
+            add(t1,t1,t1);              // 4 beta
+            add(t2,t1,t1);              // 8 beta
+            sub(X3,X3,t2);
+            add(t2,a.Y,a.Z);
+            sqr(Z3,t2);
+            sub(Z3,Z3,gamma);
+            sub(Z3,Z3,delta);
+            sub(t1,t1,X3);
+            mul(Y3,alpha,t1);
+            sqr(t2,gamma);
+            add(t2,t2,t2);
+            add(t2,t2,t2);
+            add(t2,t2,t2);              // 8 gamma^2
+            sub(Y3,Y3,t2);
+        }
+        else
+        {
+            // dbl-2009-l (a = 0)
+            limb_t A[4],B[4],C[4],D[4],E[4];
+            sqr(A,a.X);
+            sqr(B,a.Y);
+            sqr(C,B);
+            add(t1,a.X,B);
+            sqr(t1,t1);
+            sub(t1,t1,A);
+            sub(t1,t1,C);
+            add(D,t1,t1);
+            add(E,A,A);
+            add(E,E,A);
+            sqr(X3,E);
+            add(t2,D,D);
+            sub(X3,X3,t2);
+            sub(t1,D,X3);
+            mul(Y3,E,t1);
+            add(t3,C,C);
+            add(t3,t3,t3);
+            add(t3,t3,t3);
+            sub(Y3,Y3,t3);
+            mul(Z3,a.Y,a.Z);
+            add(Z3,Z3,Z3);
+        }
+        copy(r.X,X3);
+        copy(r.Y,Y3);
+        copy(r.Z,Z3);
+    }
+
+    // add-2007-bl
+    static void add(jpoint& r,const jpoint& a,const jpoint& b)
+    {
+        if(is_zero(a.Z))
+        {
+            r = b;
+            return;
+        }
+        if(is_zero(b.Z))
+        {
+            r = a;
+            return;
+        }
+        limb_t Z1Z1[4],Z2Z2[4],U1[4],U2[4],S1[4],S2[4],H[4],I[4],J[4],R[4],V[4],t[4];
+        sqr(Z1Z1,a.Z);
+        sqr(Z2Z2,b.Z);
+        mul(U1,a.X,Z2Z2);
+        mul(U2,b.X,Z1Z1);
+        mul(t,b.Z,Z2Z2);
+        mul(S1,a.Y,t);
+        mul(t,a.Z,Z1Z1);
+        mul(S2,b.Y,t);
+        sub(H,U2,U1);
+        sub(R,S2,S1);
+        if(is_zero(H))
+        {
+            if(is_zero(R)) dbl(r,a);
+            else set_inf(r);
+            return;
+        }
+        add(R,R,R);
+        add(I,H,H);
+        sqr(I,I);
+        mul(J,H,I);
+        mul(V,U1,I);
+
+        limb_t X3[4],Y3[4],Z3[4];
+        sqr(X3,R);
+        sub(X3,X3,J);
+        sub(X3,X3,V);
+        sub(X3,X3,V);
+        sub(t,V,X3);
+        mul(Y3,R,t);
+        mul(t,S1,J);
+        add(t,t,t);
+        sub(Y3,Y3,t);
+        add(t,a.Z,b.Z);
+        sqr(t,t);
+        sub(t,t,Z1Z1);
+        sub(t,t,Z2Z2);
+        mul(Z3,t,H);
+        copy(r.X,X3);
+        copy(r.Y,Y3);
+        copy(r.Z,Z3);
+    }
+
+    // madd-2007-bl: a Jacobian + b affine, 7M + 4S
+    static void madd(jpoint& r,const jpoint& a,const apoint& b)
+    {
+        if(is_zero(a.Z))
+        {
+            static const limb_t one[4] = {1,0,0,0};
+            copy(r.X,b.x);
+            copy(r.Y,b.y);
+            to_mont(r.Z,one);
+            return;
+        }
+        limb_t Z1Z1[4],U2[4],S2[4],H[4],HH[4],I[4],J[4],R[4],V[4],t[4];
+        sqr(Z1Z1,a.Z);
+        mul(U2,b.x,Z1Z1);
+        mul(t,a.Z,Z1Z1);
+        mul(S2,b.y,t);
+        sub(H,U2,a.X);
+        sub(R,S2,a.Y);
+        if(is_zero(H))
+        {
+            if(is_zero(R)) dbl(r,a);
+            else set_inf(r);
+            return;
+        }
+        add(R,R,R);
+        sqr(HH,H);
+        add(I,HH,HH);
+        add(I,I,I);
+        mul(J,H,I);
+        mul(V,a.X,I);
+
+        limb_t X3[4],Y3[4],Z3[4];
+        sqr(X3,R);
+        sub(X3,X3,J);
+        sub(X3,X3,V);
+        sub(X3,X3,V);
+        sub(t,V,X3);
+        mul(Y3,R,t);
+        mul(t,a.Y,J);
+        add(t,t,t);
+        sub(Y3,Y3,t);
+        add(t,a.Z,H);
+        sqr(t,t);
+        sub(t,t,Z1Z1);
+        sub(Z3,t,HH);
+        copy(r.X,X3);
+        copy(r.Y,Y3);
+        copy(r.Z,Z3);
+    }
+
+    // Chuan hoa count diem (khac vo cuc) ve affine voi mot phep nghich dao:
+    // pre[i] = Z_0...Z_i, nghich dao pre[count-1] roi lan nguoc de tach tung Z_i^-1
+    static void batch_to_affine(apoint* r,const jpoint* a,int count)
+    {
+        std::vector<limb_t> pre(4*count);
+        copy(&pre[0],a[0].Z);
+        for(int i = 1; i < count; i++) mul(&pre[4*i],&pre[4*(i-1)],a[i].Z);
+        limb_t zi[4],zi2[4],t[4],acc[4];
+        inv(acc,&pre[4*(count-1)]);
+        for(int i = count - 1; i >= 0; i--)
+        {
+            if(i > 0)
+            {
+                mul(zi,acc,&pre[4*(i-1)]);
+                mul(acc,acc,a[i].Z);
+            }
+            else copy(zi,acc);
+            sqr(zi2,zi);
+            mul(r[i].x,a[i].X,zi2);
+            mul(t,zi2,zi);
+            mul(r[i].y,a[i].Y,t);
+        }
+    }
+
+    // Lo Jacobian a (Montgomery) -> lo affine r dang thuong, mot phep nghich dao cho
+    // ca lo; diem vo cuc (Z = 0) duoc bo qua trong tich tien to
+    static void batch_to_affine(const curve256_soa_view& r,const curve256_soa_view& a)
+    {
+        std::vector<limb_t> pre(4*a.n + 4);
+        limb_t z[4],zi[4],zi2[4],t[4],acc[4];
+        static const limb_t one[4] = {1,0,0,0};
+        to_mont(acc,one);
+        copy(&pre[0],acc);
+        for(long i = 0; i < a.n; i++)
+        {
+            curve256_soa_get(z,a.Z,a,i);
+            if(!is_zero(z)) mul(acc,acc,z);
+            copy(&pre[4*(i+1)],acc);
+        }
+        inv(acc,acc);
+        for(long i = a.n - 1; i >= 0; i--)
+        {
+            curve256_soa_get(z,a.Z,a,i);
+            r.inf[i] = is_zero(z);
+            if(r.inf[i]) continue;
+            mul(zi,acc,&pre[4*i]);
+            mul(acc,acc,z);
+            sqr(zi2,zi);
+            curve256_soa_get(z,a.X,a,i);
+            mul(t,z,zi2);
+            from_mont(t,t);
+            curve256_soa_put(r.X,r,i,t);
+            mul(t,zi2,zi);
+            curve256_soa_get(z,a.Y,a,i);
+            mul(t,z,t);
+            from_mont(t,t);
+            curve256_soa_put(r.Y,r,i,t);
+        }
+    }
+
+    static void soa_put(const curve256_soa_view& r,long i,const jpoint& a)
+    {
+        curve256_soa_put(r.X,r,i,a.X);
+        curve256_soa_put(r.Y,r,i,a.Y);
+        curve256_soa_put(r.Z,r,i,a.Z);
+    }
+
+    // T[i] la bang cua so cua a[i]: T[i][j-1] = j*a[i], tat ca chung mot phep nghich dao
+    static void window_tables(window* T,const jpoint* a,int count)
+    {
+        std::vector<jpoint> J(15*count);
+        for(int i = 0; i < count; i++)
+        {
+            jpoint* row = &J[15*i];
+            row[0] = a[i];
+            dbl(row[1],a[i]);
+            for(int j = 2; j < 15; j++) add(row[j],row[j-1],a[i]);
+        }
+        batch_to_affine(T[0],&J[0],15*count);
+    }
+
+    // r = k*a, cua so 4 bit co dinh
+    static void scalar_mul(jpoint& r,const limb_t* k,const jpoint& a)
+    {
+        window T;
+        window_tables(&T,&a,1);
+        const apoint* t = T;
+        multi_scalar_mul(r,(const limb_t (*)[4])k,&t,1);
+    }
+
+    // r = sum k[i]*a[i] (Straus) voi T[i] la bang cua so affine cua a[i]: chung
+    // phep nhan doi, moi chu so khac 0 mot phep cong hon hop
+    static void multi_scalar_mul(jpoint& r,const limb_t (*k)[4],const apoint* const* T,int count)
+    {
+        int top = -1;
+        for(int i = 0; i < count; i++)
+            for(int j = 63; j > top; j--)
+                if((k[i][j/16] >> (4*(j%16))) & 15) top = j;
+
+        jpoint R;
+        set_inf(R);
+        for(int j = top; j >= 0; j--)
+        {
+            dbl(R,R);
+            dbl(R,R);
+            dbl(R,R);
+            dbl(R,R);
+            for(int i = 0; i < count; i++)
+            {
+                int d = (int)(k[i][j/16] >> (4*(j%16))) & 15;
+                if(d) madd(R,R,T[i][d-1]);
+            }
+        }
+        r = R;
+    }
+
+    // Bang cua G tinh mot lan cho ca tien trinh (khoi tao static an toan luong):
+    // bang cua so 4 bit va bang comb 4 x 64 bit, comb[j-1] = sum_{bit i cua j} 2^(64i) G
+    struct g_tables
+    {
+        window win;
+        window comb;
+    };
+
+    static const g_tables& g()
+    {
+        static const g_tables t = build_g();
+        return t;
+    }
+
+    static g_tables build_g()
+    {
+        g_tables t;
+        jpoint J[30],B[4];
+        from_affine(B[0],P::gx,P::gy);
+        for(int i = 1; i < 4; i++)
+        {
+            B[i] = B[i-1];
+            for(int j = 0; j < 64; j++) dbl(B[i],B[i]);
+        }
+        J[0] = B[0];
+        dbl(J[1],B[0]);
+        for(int j = 2; j < 15; j++) add(J[j],J[j-1],B[0]);
+        for(int j = 1; j < 16; j++)
+        {
+            int i = 0;
+            while(!((j >> i) & 1)) i++;
+            if(j == (1 << i)) J[14+j] = B[i];
+            else add(J[14+j],J[14+(j & ~(1 << i))],B[i]);
+        }
+        apoint A[30];
+        batch_to_affine(A,J,30);
+        for(int j = 0; j < 15; j++)
+        {
+            t.win[j] = A[j];
+            t.comb[j] = A[15+j];
+        }
+        return t;
+    }
+
+    // r = k*G bang comb: 64 phep nhan doi va toi da 64 phep cong hon hop
+    static void mul_g(jpoint& r,const limb_t* k)
+    {
+        const window& T = g().comb;
+        jpoint R;
+        set_inf(R);
+        for(int col = 63; col >= 0; col--)
+        {
+            dbl(R,R);
+            int j = 0;
+            for(int i = 3; i >= 0; i--) j = (j << 1) | (int)((k[i] >> col) & 1);
+            if(j) madd(R,R,T[j-1]);
+        }
+        r = R;
+    }
+
+    // (x,y) thuong (khong Montgomery); false neu la diem vo cuc
+    static bool to_affine(limb_t* x,limb_t* y,const jpoint& a)
+    {
+        if(is_zero(a.Z)) return false;
+        limb_t zi[4],zi2[4],t[4];
+        inv(zi,a.Z);
+        sqr(zi2,zi);
+        mul(t,a.X,zi2);
+        from_mont(x,t);
+        mul(t,zi2,zi);
+        mul(t,a.Y,t);
+        from_mont(y,t);
+        return true;
+    }
+
+    static void from_affine(jpoint& r,const limb_t* x,const limb_t* y)
+    {
+        static const limb_t one[4] = {1,0,0,0};
+        to_mont(r.X,x);
+        to_mont(r.Y,y);
+        to_mont(r.Z,one);
+    }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+#include <NTL/ZZ_p.h>
+#include "curvep.h"
+
+using namespace NTL;
+
+// Ngu canh ZZ_p cua E (mod p hoac mod n) den het pham vi, roi tra lai ngu canh cu
+// cua luong; E chua qua curve_field_init thi dung ngu canh tam tao tu m
+class curvep_push
+{
+    ZZ_pBak bak;
+    curvep_push(const curvep_push&);
+    void operator=(const curvep_push&);
+public:
+    curvep_push(const ZZ_pContext& c,const ZZ& m)
+    {
+        bak.save();
+        if(E.red) c.restore();
+        else ZZ_pContext(m).restore();
+    }
+};
+
+void curvep_double(point& c,const point& b)
+{
+    if(b.inf)
+    {
+        c.inf = true;
+        return;
+    }
+    curvep_push push(E.fp,E.p);
+    ZZ_p x = conv<ZZ_p>(b.x);
+    ZZ_p y = conv<ZZ_p>(b.y);
+    if(IsZero(y))
+    {
+        c.inf = true;
+        return;
+    }
+    // lamda = (3x^2 + a)/2y
+    ZZ_p l = (3*sqr(x) + conv<ZZ_p>(E.a))/(2*y);
+    ZZ_p x3 = sqr(l) - 2*x;
+    c.y = rep(l*(x - x3) - y);
+    c.x = rep(x3);
+    c.inf = false;
+}
+
+void curvep_add(point& c,const point& a,const point& b)
+{
+    if(b.inf)
+    {
+        c = a;
+        return;
+    }
+    if(a.inf)
+    {
+        c = b;
+        return;
+    }
+    curvep_push push(E.fp,E.p);
+    ZZ_p x1 = conv<ZZ_p>(a.x), y1 = conv<ZZ_p>(a.y);
+    ZZ_p x2 = conv<ZZ_p>(b.x), y2 = conv<ZZ_p>(b.y);
+    if(x1 == x2)
+    {
+        // b = a thi nhan doi, b = -a thi vo cuc
+        if(y1 == y2) curvep_double(c,a);
+        else c.inf = true;
+        return;
+    }
+    // lamda = (y2 - y1)/(x2 - x1)
+    ZZ_p l = (y2 - y1)/(x2 - x1);
+    ZZ_p x3 = sqr(l) - x1 - x2;
+    c.y = rep(l*(x1 - x3) - y1);
+    c.x = rep(x3);
+    c.inf = false;
+}
+
+void curvep_sign_s(ZZ& s,const ZZ& k,const ZZ& m,const ZZ& d,const ZZ& r)
+{
+    curvep_push push(E.fn,E.n);
+    s = rep((conv<ZZ_p>(m) + conv<ZZ_p>(d)*conv<ZZ_p>(r))/conv<ZZ_p>(k));
+}
+
+void curvep_verify_u(ZZ& u1,ZZ& u2,const ZZ& m,const ZZ& r,const ZZ& s)
+{
+    curvep_push push(E.fn,E.n);
+    ZZ_p w = inv(conv<ZZ_p>(s));
+    u1 = rep(conv<ZZ_p>(m)*w);
+    u2 = rep(conv<ZZ_p>(r)*w);
+}
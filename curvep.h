@@ -0,0 +1,21 @@
+#ifndef CURVEP_H
+#define CURVEP_H
+
+#include <NTL/ZZ_p.h>
+#include "ecc.h"
+
+// Phep tinh duong cong tren ZZ_p cua NTL, dung duoc voi moi p nap tu file: toa do
+// la ZZ_p theo E.fp, so vo huong la ZZ_p theo E.fn (curve_field_init). Moi ham tu
+// dat ngu canh ZZ_p can dung cho luong hien tai va tra lai ngu canh cu khi ra, nen
+// goi duoc tu nhieu luong va tu ben trong ma dang dung ZZ_p khac.
+
+// C = A + B, C = 2B (affine)
+void curvep_add(point& c,const point& a,const point& b);
+void curvep_double(point& c,const point& b);
+
+// s = k^-1 (m + d*r) mod n, 0 < k < n
+void curvep_sign_s(ZZ& s,const ZZ& k,const ZZ& m,const ZZ& d,const ZZ& r);
+// u1 = m/s, u2 = r/s mod n, 0 < s < n
+void curvep_verify_u(ZZ& u1,ZZ& u2,const ZZ& m,const ZZ& r,const ZZ& s);
+
+#endif
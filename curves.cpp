@@ -0,0 +1,451 @@
+#include <NTL/ZZ.h>
+#include <NTL/BasicThreadPool.h>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include "convert.h"
+#include "encode.h"
+#include "sha.h"
+#include "curves.h"
+
+using namespace std;
+using namespace NTL;
+
+struct named_curve_s
+{
+    const char* names[4];
+    const char* p;
+    const char* a;
+    const char* b;
+    const char* gx;
+    const char* gy;
+    const char* n;
+    long h;
+};
+
+typedef struct named_curve_s named_curve;
+
+// Tham so theo FIPS 186-4 / SEC 2 / RFC 5639
+static const named_curve named_curves[] =
+{
+    {{"P-256","secp256r1","prime256v1",0},
+     "ffffffff00000001000000000000000000000000ffffffffffffffffffffffff",
+     "ffffffff00000001000000000000000000000000fffffffffffffffffffffffc",
+     "5ac635d8aa3a93e7b3ebbd55769886bc651d06b0cc53b0f63bce3c3e27d2604b",
+     "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296",
+     "4fe342e2fe1a7f9b8ee7eb4a7c0f9e162bce33576b315ececbb6406837bf51f5",
+     "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551",1},
+    {{"secp256k1",0,0,0},
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f",
+     "00",
+     "07",
+     "79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798",
+     "483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8",
+     "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141",1},
+    {{"P-384","secp384r1",0,0},
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffeffffffff0000000000000000ffffffff",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffeffffffff0000000000000000fffffffc",
+     "b3312fa7e23ee7e4988e056be3f82d19181d9c6efe8141120314088f5013875ac656398d8a2ed19d2a85c8edd3ec2aef",
+     "aa87ca22be8b05378eb1c71ef320ad746e1d3b628ba79b9859f741e082542a385502f25dbf55296c3a545e3872760ab7",
+     "3617de4a96262c6f5d9e98bf9292dc29f8f41dbd289a147ce9da3113b5f0b8c00a60b1ce1d7e819d7a431d7c90ea0e5f",
+     "ffffffffffffffffffffffffffffffffffffffffffffffffc7634d81f4372ddf581a0db248b0a77aecec196accc52973",1},
+    {{"brainpoolP256r1",0,0,0},
+     "a9fb57dba1eea9bc3e660a909d838d726e3bf623d52620282013481d1f6e5377",
+     "7d5a0975fc2c3057eef67530417affe7fb8055c126dc5c6ce94a4b44f330b5d9",
+     "26dc5c6ce94a4b44f330b5d9bbd77cbf958416295cf7e1ce6bccdc18ff8c07b6",
+     "8bd2aeb9cb7e57cb2c4b482ffc81b7afb9de27e1e3bd23c23a4453bd9ace3262",
+     "547ef835c3dac4fd97f8461a14611dc9c27745132ded8e545c1d54c72f046997",
+     "a9fb57dba1eea9bc3e660a909d838d718c397aa3b561a6f7901e0e82974856a7",1},
+    {{"brainpoolP384r1",0,0,0},
+     "8cb91e82a3386d280f5d6f7e50e641df152f7109ed5456b412b1da197fb71123acd3a729901d1a71874700133107ec53",
+     "7bc382c63d8c150c3c72080ace05afa0c2bea28e4fb22787139165efba91f90f8aa5814a503ad4eb04a8c7dd22ce2826",
+     "04a8c7dd22ce28268b39b55416f0447c2fb77de107dcd2a62e880ea53eeb62d57cb4390295dbc9943ab78696fa504c11",
+     "1d1c64f068cf45ffa2a63a81b7c13f6b8847a3e77ef14fe3db7fcafe0cbd10e8e826e03436d646aaef87b2e247d4af1e",
+     "8abe1d7520f9c2a45cb1eb8e95cfd55262b70b29feec5864e19c054ff99129280e4646217791811142820341263c5315",
+     "8cb91e82a3386d280f5d6f7e50e641df152f7109ed5456b31f166e6cac0425a7cf3ab6af6b7fc3103b883202e9046565",1},
+};
+
+static const long named_curve_count = sizeof(named_curves)/sizeof(named_curves[0]);
+
+struct curve_path_s
+{
+    long long mtime;
+    long long size;
+    const curve_info* info;
+};
+
+typedef struct curve_path_s curve_path;
+
+static const char table_magic[8] = {'E','C','D','S','A','G','T','1'};
+
+static vector<curve_info*> registry;
+static map<string,curve_path> path_cache;
+
+const curve_info* curve_active = 0;
+
+static void named_to_curve(curve& E,const named_curve& c)
+{
+    conv_hex_to_ZZ(E.p,(char*)c.p);
+    conv_hex_to_ZZ(E.a,(char*)c.a);
+    conv_hex_to_ZZ(E.b,(char*)c.b);
+    conv_hex_to_ZZ(E.G.x,(char*)c.gx);
+    conv_hex_to_ZZ(E.G.y,(char*)c.gy);
+    E.G.inf = false;
+    conv_hex_to_ZZ(E.n,(char*)c.n);
+    conv(E.h,c.h);
+}
+
+// p | a | b | Gx | Gy (field_size byte) | n | h (scalar_size byte)
+void curve_fingerprint(unsigned char* fp,const curve& E)
+{
+    long fs = field_size(E);
+    long ss = scalar_size(E);
+    vector<unsigned char> buf(5*fs + 2*ss);
+    unsigned char* p = &buf[0];
+    conv_ZZ_to_bytes(p,E.p,fs);
+    conv_ZZ_to_bytes(p + fs,E.a % E.p,fs);
+    conv_ZZ_to_bytes(p + 2*fs,E.b % E.p,fs);
+    conv_ZZ_to_bytes(p + 3*fs,E.G.x,fs);
+    conv_ZZ_to_bytes(p + 4*fs,E.G.y,fs);
+    conv_ZZ_to_bytes(p + 5*fs,E.n,ss);
+    conv_ZZ_to_bytes(p + 5*fs + ss,E.h,ss);
+    hash_buffer(p,buf.size(),SHA_256,fp);
+}
+
+static bool curve_valid(const curve& E)
+{
+    const ZZ& p = E.p;
+    if(p <= 3 || !IsOdd(p) || E.n <= 1 || E.h < 1) return false;
+    // 4a^3 + 27b^2 != 0 (mod p)
+    ZZ a = E.a % p, b = E.b % p;
+    ZZ disc = (4*MulMod(SqrMod(a,p),a,p) + 27*SqrMod(b,p)) % p;
+    if(IsZero(disc)) return false;
+    return is_on_curve(E.G,E);
+}
+
+// Phep toan diem dung E toan cuc; chi goi khi E la c.E (active_entry), khong doi E
+// vi ham nay co the chay tren luong phu trong khi cac luong khac dang doc E.
+// Tinh bang comb do rong CURVE_COMB_WIDTH: P_i = 2^(i*d) G, d = ceil(bitlen(n)/w).
+static void build_comb(curve_info& c)
+{
+    const long w = CURVE_COMB_WIDTH;
+    c.comb_d = (NumBits(c.E.n) + w - 1)/w;
+    c.comb.resize((1L << w) - 1);
+
+    // cac diem tinh o dang Jacobian, chuan hoa ve affine mot lan o cuoi
+    jpoint P[CURVE_COMB_WIDTH];
+    vector<jpoint> J((1L << w) - 1);
+    to_jacobian(P[0],c.E.G);
+    for(long i = 1; i < w; i++)
+    {
+        P[i] = P[i-1];
+        for(long j = 0; j < c.comb_d; j++)
+            jacobian_double(P[i],P[i]);
+    }
+    for(long j = 1; j < (1L << w); j++)
+    {
+        long i = 0;
+        while(!((j >> i) & 1)) i++;
+        if(j == (1L << i))
+            J[j-1] = P[i];
+        else
+            jacobian_add(J[j-1],J[(j & ~(1L << i)) - 1],P[i]);
+    }
+    batch_to_affine(&c.comb[0],&J[0],J.size());
+}
+
+const curve_info* curve_register(const curve& E)
+{
+    if(!curve_valid(E)) return 0;
+    unsigned char fp[CURVE_FINGERPRINT_LENGTH];
+    curve_fingerprint(fp,E);
+    for(size_t i = 0; i < registry.size(); i++)
+        if(memcmp(registry[i]->fingerprint,fp,CURVE_FINGERPRINT_LENGTH) == 0)
+            return registry[i];
+
+    curve_info* c = new curve_info;
+    c->name = 0;
+    c->E = E;
+    c->E.a = E.a % E.p;
+    c->E.b = E.b % E.p;
+    c->E.a_kind = curve_a_kind(c->E);
+    curve_field_init(c->E);
+    memcpy(c->fingerprint,fp,CURVE_FINGERPRINT_LENGTH);
+    c->field_len = field_size(E);
+    c->scalar_len = scalar_size(E);
+    c->fast = curve256_match(c->E);
+    c->comb_d = 0;
+    c->table = 0;
+    c->table_w = 0;
+    c->table_windows = 0;
+    memset(&c->table_map,0,sizeof(c->table_map));
+
+    // file chua tham so cua mot duong cong co ten thi lay ten do
+    for(long i = 0; i < named_curve_count && !c->name; i++)
+    {
+        ZZ p;
+        conv_hex_to_ZZ(p,(char*)named_curves[i].p);
+        if(p != c->E.p) continue;
+        curve N;
+        named_to_curve(N,named_curves[i]);
+        unsigned char nfp[CURVE_FINGERPRINT_LENGTH];
+        curve_fingerprint(nfp,N);
+        if(memcmp(nfp,fp,CURVE_FINGERPRINT_LENGTH) == 0) c->name = named_curves[i].names[0];
+    }
+    registry.push_back(c);
+    return c;
+}
+
+const curve_info* curve_named(const char* name)
+{
+    for(long i = 0; i < named_curve_count; i++)
+    {
+        for(int j = 0; j < 4 && named_curves[i].names[j]; j++)
+        {
+            if(strcmp(name,named_curves[i].names[j]) != 0) continue;
+            curve N;
+            named_to_curve(N,named_curves[i]);
+            return curve_register(N);
+        }
+    }
+    return 0;
+}
+
+static bool read_curve_file(curve& E,const char* path)
+{
+    ifstream in;
+    in.open(path);
+    if(!in.is_open()) return false;
+    char temp[256];
+    ZZ* fields[7] = {&E.p,&E.a,&E.b,&E.G.x,&E.G.y,&E.n,&E.h};
+    for(int i = 0; i < 7; i++)
+    {
+        if(!in.getline(temp,sizeof(temp))) return false;
+        long len = strlen(temp);
+        if(len > 0 && temp[len-1] == '\r') temp[len-1] = '\0';
+        conv_hex_to_ZZ(*fields[i],temp);
+    }
+    E.G.inf = false;
+    return true;
+}
+
+// File da doc duoc nho theo (duong dan, mtime, kich thuoc), chi doc lai khi file doi
+const curve_info* curve_open(const char* path)
+{
+    const curve_info* c = curve_named(path);
+    if(c) return c;
+
+    struct stat st;
+    if(stat(path,&st) != 0) return 0;
+    map<string,curve_path>::iterator it = path_cache.find(path);
+    if(it != path_cache.end() && it->second.mtime == (long long)st.st_mtime && it->second.size == (long long)st.st_size)
+        return it->second.info;
+
+    curve F;
+    if(!read_curve_file(F,path)) return 0;
+    c = curve_register(F);
+    if(!c) return 0;
+    curve_path& cp = path_cache[path];
+    cp.mtime = st.st_mtime;
+    cp.size = st.st_size;
+    cp.info = c;
+    return c;
+}
+
+void curve_use(const curve_info* c)
+{
+    E = c->E;
+    curve_active = c;
+}
+
+static curve_info* entry_of(const curve_info* c)
+{
+    for(size_t i = 0; i < registry.size(); i++)
+        if(registry[i] == c) return registry[i];
+    return 0;
+}
+
+// curve_active neu E chua bi doi tu luc curve_use
+static curve_info* active_entry()
+{
+    curve_info* c = entry_of(curve_active);
+    if(!c || c->E.p != E.p || c->E.G.x != E.G.x || c->E.G.y != E.G.y) return 0;
+    return c;
+}
+
+// than file bang G (E phai la c.E): voi moi cua so i, B = 2^(w*i) G va cac diem B, 2B, ..., (2^w - 1)B
+static void build_table(const curve_info& c,long w,vector<unsigned char>& body)
+{
+    long fs = c.field_len;
+    long per = (1L << w) - 1;
+    long windows = (NumBits(c.E.n) + w - 1)/w;
+    body.resize(windows*per*2*fs);
+
+    // toan bo bang tinh o dang Jacobian, chuan hoa ve affine voi mot phep nghich dao
+    vector<jpoint> J(windows*per);
+    vector<point> T(windows*per);
+    jpoint B;
+    to_jacobian(B,c.E.G);
+    for(long i = 0; i < windows; i++)
+    {
+        jpoint* row = J.empty() ? 0 : &J[i*per];
+        row[0] = B;
+        for(long j = 1; j < per; j++)
+            jacobian_add(row[j],row[j-1],B);
+        // B = 2^w * B
+        jacobian_add(B,row[per-1],B);
+    }
+    if(!J.empty()) batch_to_affine(&T[0],&J[0],J.size());
+
+    unsigned char* out = body.empty() ? 0 : &body[0];
+    for(size_t i = 0; i < T.size(); i++, out += 2*fs)
+        encode_point(out,T[i],fs);
+}
+
+bool curve_table_save(const curve_info* c,const char* path,long w)
+{
+    if(w < 1 || w > 8 || c != active_entry()) return false;
+    vector<unsigned char> body;
+    build_table(*c,w,body);
+
+    unsigned char h[128];
+    memset(h,0,sizeof(h));
+    memcpy(h,table_magic,8);
+    conv_ull_to_le(h + 8,CURVE_TABLE_VERSION,4);
+    conv_ull_to_le(h + 12,w,4);
+    conv_ull_to_le(h + 16,c->field_len,4);
+    conv_ull_to_le(h + 20,body.size()/(((1L << w) - 1)*2*c->field_len),4);
+    conv_ull_to_le(h + 24,(1L << w) - 1,4);
+    memcpy(h + 32,c->fingerprint,CURVE_FINGERPRINT_LENGTH);
+    hash_buffer(&body[0],body.size(),SHA_256,h + 64);
+
+    FILE* file = fopen(path,"wb");
+    if(!file) return false;
+    bool ok = fwrite(h,1,sizeof(h),file) == sizeof(h);
+    ok = ok && fwrite(&body[0],1,body.size(),file) == body.size();
+    ok = (fclose(file) == 0) && ok;
+    return ok;
+}
+
+// Kiem tra phien ban, duong cong, kich thuoc va checksum truoc khi dung
+bool curve_table_map(const curve_info* ci,const char* path)
+{
+    curve_info* c = entry_of(ci);
+    if(!c) return false;
+    mapped_file m;
+    if(!map_file(path,m)) return false;
+    const unsigned char* h = m.data;
+    bool ok = m.size >= 128 && memcmp(h,table_magic,8) == 0
+              && conv_le_to_ull(h + 8,4) == CURVE_TABLE_VERSION
+              && memcmp(h + 32,c->fingerprint,CURVE_FINGERPRINT_LENGTH) == 0;
+    long w = ok ? (long)conv_le_to_ull(h + 12,4) : 0;
+    ok = ok && w >= 1 && w <= 8
+         && (long)conv_le_to_ull(h + 16,4) == c->field_len
+         && (long)conv_le_to_ull(h + 20,4) == (NumBits(c->E.n) + w - 1)/w
+         && (long)conv_le_to_ull(h + 24,4) == (1L << w) - 1;
+    unsigned long long body = ok ? conv_le_to_ull(h + 20,4)*((1L << w) - 1)*2*c->field_len : 0;
+    ok = ok && m.size == 128 + body;
+    if(ok)
+    {
+        unsigned char sum[CURVE_FINGERPRINT_LENGTH];
+        hash_buffer(h + 128,body,SHA_256,sum);
+        ok = memcmp(sum,h + 64,CURVE_FINGERPRINT_LENGTH) == 0;
+    }
+    if(!ok)
+    {
+        unmap_file(m);
+        return false;
+    }
+    unmap_file(c->table_map);
+    c->table_map = m;
+    c->table = h + 128;
+    c->table_w = w;
+    c->table_windows = (long)conv_le_to_ull(h + 20,4);
+    return true;
+}
+
+bool curve_fast_multi_point(point& a,const ZZ& k,const point& b)
+{
+    curve_info* c = active_entry();
+    return c && c->fast != CURVE256_NONE && curve256_multi_point(c->fast,a,k,b);
+}
+
+bool curve_fast_multi_point2(point& a,const ZZ& k1,const ZZ& k2,const point& Q)
+{
+    curve_info* c = active_entry();
+    return c && c->fast != CURVE256_NONE && curve256_multi_point_GQ(c->fast,a,k1,k2,Q);
+}
+
+bool curve_fast_multi_point2_batch(point* a,const ZZ* k1,const ZZ* k2,const point* Q,long count)
+{
+    curve_info* c = active_entry();
+    return c && c->fast != CURVE256_NONE && curve256_batch_multi_point_GQ(c->fast,a,k1,k2,Q,count);
+}
+
+static void multi_point_G_range(point* a,const ZZ* k,long count)
+{
+    curve_info* c = active_entry();
+    if(c && c->fast != CURVE256_NONE && curve256_batch_multi_point_G(c->fast,a,k,count)) return;
+    for(long i = 0; i < count; i++) multi_point_G(a[i],k[i]);
+}
+
+// so phep nhan toi thieu cho moi phan cua lo khi chia cho cac luong
+#define G_BATCH_GRAIN 32
+
+void multi_point_G_batch(point* a,const ZZ* k,long count)
+{
+    GetThreadPool()->exec_range(count,G_BATCH_GRAIN,[&](long first,long last)
+    {
+        multi_point_G_range(a + first,k + first,last - first);
+    });
+}
+
+// Duong cong co ban bien dich san thi dung ban do (bang G mmap khong dung toi).
+// Co bang G da mmap: k*G = sum_i (chu so thu i cua k theo co so 2^w) * 2^(w*i) G,
+// chi gom phep cong. Khong co: k*G = sum_{cot} 2^cot * comb[bit cot cua k trong
+// moi doan d bit], d phep nhan doi va toi da d phep cong.
+void multi_point_G(point& a,const ZZ& k)
+{
+    curve_info* c = active_entry();
+    if(!c)
+    {
+        multi_point(a,k,E.G);
+        return;
+    }
+    if(c->fast != CURVE256_NONE && curve256_multi_point_G(c->fast,a,k)) return;
+    ZZ e = k % c->E.n;
+    point T;
+    jpoint R;
+    clear(R.Z);
+    if(c->table)
+    {
+        long fs = c->field_len;
+        long w = c->table_w;
+        long per = (1L << w) - 1;
+        for(long i = 0; i < c->table_windows; i++)
+        {
+            long j = 0;
+            for(long b = w - 1; b >= 0; b--)
+                j = (j << 1) | bit(e,i*w + b);
+            if(!j) continue;
+            decode_point(T,c->table + (i*per + j - 1)*2*fs,fs);
+            jacobian_add_affine(R,R,T);
+        }
+        to_affine(a,R);
+        return;
+    }
+    std::call_once(c->comb_once,build_comb,std::ref(*c));
+    for(long col = c->comb_d - 1; col >= 0; col--)
+    {
+        jacobian_double(R,R);
+        long j = 0;
+        for(long i = CURVE_COMB_WIDTH - 1; i >= 0; i--)
+            j = (j << 1) | bit(e,i*c->comb_d + col);
+        if(!j) continue;
+        jacobian_add_affine(R,R,c->comb[j-1]);
+    }
+    to_affine(a,R);
+}
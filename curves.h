@@ -0,0 +1,77 @@
+#ifndef CURVES_H
+#define CURVES_H
+
+#include <vector>
+#include <mutex>
+#include "ecc.h"
+#include "mapfile.h"
+#include "curve256.h"
+
+// Danh sach duong cong: cac duong cong co ten duoc bien dich san (P-256,
+// secp256k1, P-384, brainpoolP256r1, brainpoolP384r1) va duong cong doc tu
+// file. Moi duong cong duoc nhan dang bang dau van tay (SHA-256 cua tham so)
+// va chi khoi tao mot lan; file khac nhau cung tham so dung chung mot muc.
+
+#define CURVE_FINGERPRINT_LENGTH 32
+#define CURVE_COMB_WIDTH 4
+
+// File bang G tinh san (little-endian), dung chung giua cac tien trinh qua mmap:
+//   header 128 byte:
+//     0  "ECDSAGT1"      8  version       12 window w       16 field_len
+//     20 windows         24 so diem moi cua so (2^w - 1)
+//     32 dau van tay duong cong (32 byte)
+//     64 SHA-256 cua phan than (32 byte)      96..127 du tru
+//   than: windows * (2^w - 1) diem X || Y, diem [i][j-1] = j * 2^(w*i) * G
+#define CURVE_TABLE_VERSION 1
+#define CURVE_TABLE_WINDOW 8
+
+struct curve_info_s
+{
+    const char* name;           // ten chuan, 0 neu khong trung duong cong co ten
+    curve E;
+    unsigned char fingerprint[CURVE_FINGERPRINT_LENGTH];
+    long field_len;             // so byte cua toa do
+    long scalar_len;            // so byte cua so nguyen mod n
+    curve256_id fast;           // duong cong co ban bien dich san, CURVE256_NONE neu khong
+    // bang comb cua G (tinh khi can): comb[j-1] = sum_{bit i cua j} 2^(i*comb_d) * G
+    long comb_d;
+    std::vector<point> comb;
+    std::once_flag comb_once;   // comb chi tinh mot lan du nhieu luong cung can
+    // bang G da mmap (0 neu khong co)
+    mapped_file table_map;
+    const unsigned char* table;
+    long table_w;
+    long table_windows;
+};
+
+typedef struct curve_info_s curve_info;
+
+// duong cong dang dung (cung tham so voi E), 0 neu chua load
+extern const curve_info* curve_active;
+
+void curve_fingerprint(unsigned char* fp,const curve& E);
+
+// Tra ve muc trong danh sach (tao neu chua co), 0 neu tham so khong hop le
+const curve_info* curve_register(const curve& E);
+const curve_info* curve_named(const char* name);
+// path la ten duong cong hoac file 7 dong hex (p, a, b, Gx, Gy, n, h)
+const curve_info* curve_open(const char* path);
+void curve_use(const curve_info* c);
+
+// Ghi bang G cua c ra file / gan file bang G da tinh san vao c
+bool curve_table_save(const curve_info* c,const char* path,long w);
+bool curve_table_map(const curve_info* c,const char* path);
+
+// A = kG dung bang comb cua curve_active
+void multi_point_G(point& a,const ZZ& k);
+// A = kB bang ban bien dich san cua curve_active, false neu khong co
+bool curve_fast_multi_point(point& a,const ZZ& k,const point& b);
+// A = k1*G + k2*Q bang ban bien dich san (chung phep nhan doi), false neu khong co
+bool curve_fast_multi_point2(point& a,const ZZ& k1,const ZZ& k2,const point& Q);
+// Ban hang loat cua multi_point_G / curve_fast_multi_point2 (tao nhieu khoa, xac
+// thuc nhieu chu ky): ban bien dich san tinh nhieu phep nhan mot luc neu CPU ho tro;
+// multi_point_G_batch chia lo lon cho cac luong cua GetThreadPool()
+void multi_point_G_batch(point* a,const ZZ* k,long count);
+bool curve_fast_multi_point2_batch(point* a,const ZZ* k1,const ZZ* k2,const point* Q,long count);
+
+#endif
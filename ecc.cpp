@@ -0,0 +1,590 @@
+#include <NTL/ZZ.h>
+#include <NTL/BasicThreadPool.h>
+#include <vector>
+#include "ecc.h"
+#include "curves.h"
+#include "curvep.h"
+
+using namespace NTL;
+
+curve E;
+
+// x = x^(2^k) mod p
+static void sqr_n(ZZ& x,long k,const ZZ& p)
+{
+    for(long i = 0; i < k; i++)
+        SqrMod(x,x,p);
+}
+
+// P-256: (p+1)/4 = 2^254 - 2^222 + 2^190 + 2^94
+// 253 phep binh phuong + 7 phep nhan
+static void sqrt_chain_p256(ZZ& r,const ZZ& a,const ZZ& p)
+{
+    ZZ t1,t2;
+    MulMod(t1,SqrMod(a,p),a,p);             // a^(2^2-1)
+    t2 = t1; sqr_n(t2,2,p); MulMod(t1,t2,t1,p); // a^(2^4-1)
+    t2 = t1; sqr_n(t2,4,p); MulMod(t1,t2,t1,p); // a^(2^8-1)
+    t2 = t1; sqr_n(t2,8,p); MulMod(t1,t2,t1,p); // a^(2^16-1)
+    t2 = t1; sqr_n(t2,16,p); MulMod(t1,t2,t1,p); // a^(2^32-1)
+    sqr_n(t1,32,p); MulMod(t1,t1,a,p);      // a^(2^64-2^32+1)
+    sqr_n(t1,96,p); MulMod(t1,t1,a,p);      // a^(2^160-2^128+2^96+1)
+    sqr_n(t1,94,p);
+    r = t1;
+}
+
+// secp256k1: (p+1)/4 = 2^254 - 2^30 - 244, chuoi cong x2,x3,x6,...,x223
+// (x_k = a^(2^k-1)), 253 phep binh phuong + 13 phep nhan
+static void sqrt_chain_k256(ZZ& r,const ZZ& a,const ZZ& p)
+{
+    ZZ x2,x3,x6,x9,x11,x22,x44,x88,x176,x220,x223,t;
+    MulMod(x2,SqrMod(a,p),a,p);
+    MulMod(x3,SqrMod(x2,p),a,p);
+    x6 = x3; sqr_n(x6,3,p); MulMod(x6,x6,x3,p);
+    x9 = x6; sqr_n(x9,3,p); MulMod(x9,x9,x3,p);
+    x11 = x9; sqr_n(x11,2,p); MulMod(x11,x11,x2,p);
+    x22 = x11; sqr_n(x22,11,p); MulMod(x22,x22,x11,p);
+    x44 = x22; sqr_n(x44,22,p); MulMod(x44,x44,x22,p);
+    x88 = x44; sqr_n(x88,44,p); MulMod(x88,x88,x44,p);
+    x176 = x88; sqr_n(x176,88,p); MulMod(x176,x176,x88,p);
+    x220 = x176; sqr_n(x220,44,p); MulMod(x220,x220,x44,p);
+    x223 = x220; sqr_n(x223,3,p); MulMod(x223,x223,x3,p);
+    t = x223; sqr_n(t,23,p); MulMod(t,t,x22,p);
+    sqr_n(t,6,p); MulMod(t,t,x2,p);
+    sqr_n(t,2,p);
+    r = t;
+}
+
+// Tonelli-Shanks cho p bat ky: p - 1 = q*2^s, q le; w = a^((q-1)/2) mod p
+static bool tonelli_shanks(ZZ& r,const ZZ& a,const ZZ& w,const ZZ& p)
+{
+    ZZ q = p - 1;
+    long s = MakeOdd(q);
+
+    ZZ z(2);
+    while(Jacobi(z,p) != -1) z++;
+
+    ZZ c = PowerMod(z,q,p);
+    // x = a^((q+1)/2), t = a^q
+    ZZ x = MulMod(a,w,p);
+    ZZ t = MulMod(x,w,p);
+    long m = s;
+    while(!IsOne(t))
+    {
+        // tim i nho nhat de t^(2^i) = 1
+        long i = 0;
+        ZZ t2 = t;
+        while(!IsOne(t2))
+        {
+            SqrMod(t2,t2,p);
+            i++;
+            if(i == m) return false;
+        }
+        ZZ b = c;
+        sqr_n(b,m - i - 1,p);
+        MulMod(x,x,b,p);
+        SqrMod(c,b,p);
+        MulMod(t,t,c,p);
+        m = i;
+    }
+    r = x;
+    return true;
+}
+
+static const char* p256_p = "115792089210356248762697446949407573530086143415290314195533631308867097853951";
+static const char* k256_p = "115792089237316195423570985008687907853269984665640564039457584007908834671663";
+
+// Luy thua co dinh cua sqrt mod p: (p+1)/4 neu p = 3 mod 4, nguoc lai (q-1)/2
+static void sqrt_exponent(ZZ& e,const ZZ& p)
+{
+    if(rem(p,4) == 3)
+    {
+        e = (p + 1)/4;
+        return;
+    }
+    e = p - 1;
+    MakeOdd(e);
+    e = (e - 1)/2;
+}
+
+// pw: luy thua sqrt_exponent(p) dung chung cho p, rong thi dung PowerMod
+static bool sqrt_mod(ZZ& r,const ZZ& a,const ZZ& p,const ZZ_PowerModStruct* pw)
+{
+    static const ZZ P256 = conv<ZZ>(p256_p);
+    static const ZZ K256 = conv<ZZ>(k256_p);
+
+    ZZ x = a % p;
+    if(IsZero(x))
+    {
+        clear(r);
+        return true;
+    }
+    ZZ y;
+    if(p == P256) sqrt_chain_p256(y,x,p);
+    else if(p == K256) sqrt_chain_k256(y,x,p);
+    else
+    {
+        ZZ w;
+        if(pw) pw->eval(w,x);
+        else
+        {
+            ZZ e;
+            sqrt_exponent(e,p);
+            PowerMod(w,x,e,p);
+        }
+        if(rem(p,4) == 3) y = w;
+        else if(!tonelli_shanks(y,x,w,p)) return false;
+    }
+
+    if(SqrMod(y,p) != x) return false;
+    r = y;
+    return true;
+}
+
+bool sqrt_mod(ZZ& r,const ZZ& a,const ZZ& p)
+{
+    return sqrt_mod(r,a,p,0);
+}
+
+bool sqrt_mod(ZZ& r,const ZZ& a,const curve& E)
+{
+    return sqrt_mod(r,a,E.p,E.sqrt_pw.get());
+}
+
+int curve_a_kind(const curve& E)
+{
+    ZZ a = E.a % E.p;
+    if(IsZero(a)) return CURVE_A_ZERO;
+    if(a == E.p - 3) return CURVE_A_MINUS_3;
+    return CURVE_A_GENERIC;
+}
+
+// red: Montgomery neu p le (R = 2^(50k), k so chu so cua p), dau vao la tich hai so < p
+void curve_field_init(curve& E)
+{
+    E.red = MakeSmart<ZZ_ReduceStructAdapter>();
+    E.red->init(E.p,sqr(E.p));
+    E.fp = ZZ_pContext(E.p);
+    E.fn = ZZ_pContext(E.n);
+    ZZ e;
+    sqrt_exponent(e,E.p);
+    E.sqrt_pw = MakeSmart<ZZ_PowerModStruct>();
+    E.sqrt_pw->init(e,E.p);
+}
+
+// y^2 = x^3 + ax + b (mod p), 0 <= x,y < p
+bool is_on_curve(const point& P,const curve& E)
+{
+    const ZZ& p = E.p;
+    if(P.inf) return false;
+    if(sign(P.x) < 0 || P.x >= p || sign(P.y) < 0 || P.y >= p) return false;
+    ZZ lhs = SqrMod(P.y,p);
+    ZZ rhs = (MulMod(SqrMod(P.x,p),P.x,p) + MulMod(E.a % p,P.x,p) + E.b) % p;
+    return lhs == rhs;
+}
+
+// m = bits2int(H): lay bitlen(n) bit ben trai cua digest (FIPS 186-4, 6.4)
+void bits2int(ZZ& m,const unsigned char* h,long len,const ZZ& n)
+{
+    unsigned char temp[MAX_BITS2INT_BYTES];
+    for(long i = 0; i < len; i++)
+        temp[i] = h[len-1-i];
+    ZZFromBytes(m,temp,len);
+    long excess = 8*len - NumBits(n);
+    if(excess > 0) RightShift(m,m,excess);
+}
+
+void ecdsa_sign(signature& sig,const ZZ& d,const ZZ& m)
+{
+    // so tam cua mot lan ky lay tu arena cua luong, khong qua malloc
+    ZZArenaPush arena;
+    point Q;
+    ZZ n = E.n;
+
+    //chon k ngau nhien 2 -> n-1
+BUOC_1:
+    ZZ k = RandomLen_ZZ(NumBits(n))%(n -2) + 2;
+    //Tinh Q = kG (x1,y1)
+    multi_point_G(Q,k);
+    //Tinh r = x1 mod n
+    sig.r = Q.x%n;
+    //Neu r = 0 quay lai buoc 1
+    if(sig.r==0) goto BUOC_1;
+    else
+    {
+        //tinh s = k^-1 * (m + d*r) mod n;
+        curvep_sign_s(sig.s,k,m,d,sig.r);
+        if(sig.s == 0) goto BUOC_1;
+    }
+}
+
+bool ecdsa_verify(const point& Q,const signature& sig,const ZZ& m)
+{
+    ZZArenaPush arena;
+    const ZZ& r = sig.r;
+    const ZZ& s = sig.s;
+    const ZZ& n = E.n;
+
+    if(r>=2 && r<n && s>=2 && s<n)
+    {
+        //Tinh u1 = m/s, u2 = r/s mod n
+        ZZ u1,u2;
+        curvep_verify_u(u1,u2,m,r,s);
+
+        point X,X1,X2;
+        // Tinh X = u1*G + u2*Q
+        if(!curve_fast_multi_point2(X,u1,u2,Q))
+        {
+            multi_point_G(X1,u1);
+            multi_point(X2,u2,Q);
+            add_point(X,X1,X2);
+        }
+
+        if(X.inf)
+        {
+            return false;
+        }
+        else
+        {
+            ZZ v = X.x%n;
+            if(v==r) return true;
+        }
+    }
+    return false;
+}
+
+static void verify_batch_range(bool* ok,const point* Q,const signature* sig,const ZZ* m,long count)
+{
+    ZZArenaPush arena;
+    const ZZ& n = E.n;
+    std::vector<long> idx;
+    std::vector<ZZ> u1,u2;
+    std::vector<point> P;
+    for(long i = 0; i < count; i++)
+    {
+        const ZZ& r = sig[i].r;
+        const ZZ& s = sig[i].s;
+        ok[i] = false;
+        if(r>=2 && r<n && s>=2 && s<n)
+        {
+            idx.push_back(i);
+            u1.push_back(ZZ());
+            u2.push_back(ZZ());
+            curvep_verify_u(u1.back(),u2.back(),m[i],r,s);
+            P.push_back(Q[i]);
+        }
+    }
+    long c = idx.size();
+    if(!c) return;
+    std::vector<point> X(c);
+    if(!curve_fast_multi_point2_batch(&X[0],&u1[0],&u2[0],&P[0],c))
+    {
+        for(long j = 0; j < c; j++) ok[idx[j]] = ecdsa_verify(Q[idx[j]],sig[idx[j]],m[idx[j]]);
+        return;
+    }
+    for(long j = 0; j < c; j++)
+        ok[idx[j]] = !X[j].inf && X[j].x%n == sig[idx[j]].r;
+}
+
+// so chu ky toi thieu cho moi phan cua lo khi chia cho cac luong
+#define VERIFY_BATCH_GRAIN 32
+
+void ecdsa_verify_batch(bool* ok,const point* Q,const signature* sig,const ZZ* m,long count)
+{
+    // moi luong cua pool NTL chay ban lo tren mot doan lien tiep
+    GetThreadPool()->exec_range(count,VERIFY_BATCH_GRAIN,[&](long first,long last)
+    {
+        verify_batch_range(ok + first,Q + first,sig + first,m + first,last - first);
+    });
+}
+
+//C = A + B
+void add_point(point& c,point a,point b)
+{
+    curvep_add(c,a,b);
+}
+
+//A = 2B
+void double_point(point& a,point b)
+{
+    curvep_double(a,b);
+}
+
+//A = kB
+void multi_point(point& a,ZZ k,point b)
+{
+    if(b.inf)
+    {
+        a.inf = true;
+        return;
+    }
+    // P-256, secp256k1: ban Curve<Params> bien dich san
+    if(curve_fast_multi_point(a,k,b)) return;
+
+    // Jacobian, cua so 4 bit; bang chuan hoa ve affine bang mot phep nghich dao
+    // de vong lap chi dung phep cong hon hop
+    jpoint TJ[15],R;
+    point T[15];
+    to_jacobian(TJ[0],b);
+    jacobian_double(TJ[1],TJ[0]);
+    for(int i = 2; i < 15; i++) jacobian_add(TJ[i],TJ[i-1],TJ[0]);
+    batch_to_affine(T,TJ,15);
+
+    clear(R.Z);
+    for(long i = (NumBits(k) + 3)/4 - 1; i >= 0; i--)
+    {
+        for(int j = 0; j < 4; j++) jacobian_double(R,R);
+        long d = 0;
+        for(int j = 3; j >= 0; j--) d = (d << 1) | bit(k,4*i + j);
+        if(d) jacobian_add_affine(R,R,T[d-1]);
+    }
+    to_affine(a,R);
+}
+
+// Toa do Jacobian luu dang x*R mod p theo E.red: tich hai toa do chi can mot lan
+// rut gon Montgomery thay cho phep chia cua MulMod. Tich cua toa do voi so thuong
+// (x, y affine, he so a, hang so nho) dung MulMod va van giu dang x*R.
+// E chua co red thi R = 1 va moi phep nhan la MulMod.
+static inline ZZ fmul(const ZZ& a,const ZZ& b)
+{
+    if(!E.red) return MulMod(a,b,E.p);
+    ZZ t;
+    mul(t,a,b);
+    E.red->eval(t,t);
+    return t;
+}
+
+static inline ZZ fsqr(const ZZ& a)
+{
+    if(!E.red) return SqrMod(a,E.p);
+    ZZ t;
+    sqr(t,a);
+    E.red->eval(t,t);
+    return t;
+}
+
+// x -> x*R
+static inline ZZ to_field(const ZZ& a)
+{
+    ZZ t = a;
+    if(E.red) E.red->adjust(t);
+    return t;
+}
+
+// x*R -> x
+static inline ZZ from_field(const ZZ& a)
+{
+    ZZ t = a;
+    if(E.red) E.red->eval(t,t);
+    return t;
+}
+
+void to_jacobian(jpoint& a,const point& b)
+{
+    if(b.inf)
+    {
+        clear(a.Z);
+        return;
+    }
+    a.X = to_field(b.x);
+    a.Y = to_field(b.y);
+    a.Z = to_field(ZZ(1));
+}
+
+void to_affine(point& a,const jpoint& b)
+{
+    const ZZ& p = E.p;
+    if(IsZero(b.Z))
+    {
+        a.inf = true;
+        return;
+    }
+    ZZ zi = InvMod(from_field(b.Z),p);
+    ZZ zi2 = SqrMod(zi,p);
+    // toa do nhan so thuong qua fmul cho ra dang thuong
+    a.x = fmul(b.X,zi2);
+    a.y = fmul(b.Y,MulMod(zi2,zi,p));
+    a.inf = false;
+}
+
+// A = 2B, cong thuc theo E.a_kind (EFD):
+//   a = -3 : dbl-2001-b, M = 3(X - Z^2)(X + Z^2)
+//   a = 0  : dbl-2009-l, M = 3X^2
+//   khac   : dbl-2007-bl, M = 3X^2 + aZ^4
+void jacobian_double(jpoint& a,const jpoint& b)
+{
+    const ZZ& p = E.p;
+    if(IsZero(b.Z) || IsZero(b.Y))
+    {
+        clear(a.Z);
+        return;
+    }
+    ZZ X3,Y3,Z3,t;
+    if(E.a_kind == CURVE_A_MINUS_3)
+    {
+        ZZ delta = fsqr(b.Z);
+        ZZ gamma = fsqr(b.Y);
+        ZZ beta = fmul(b.X,gamma);
+        ZZ alpha = fmul(SubMod(b.X,delta,p),AddMod(b.X,delta,p));
+        alpha = MulMod(alpha,3,p);
+        ZZ beta4 = MulMod(beta,4,p);
+        X3 = SubMod(fsqr(alpha),AddMod(beta4,beta4,p),p);
+        Z3 = SubMod(SubMod(fsqr(AddMod(b.Y,b.Z,p)),gamma,p),delta,p);
+        Y3 = SubMod(fmul(alpha,SubMod(beta4,X3,p)),MulMod(fsqr(gamma),8,p),p);
+    }
+    else
+    {
+        ZZ A = fsqr(b.X);
+        ZZ B = fsqr(b.Y);
+        ZZ C = fsqr(B);
+        t = SubMod(SubMod(fsqr(AddMod(b.X,B,p)),A,p),C,p);
+        ZZ D = AddMod(t,t,p);
+        ZZ M = MulMod(A,3,p);
+        if(E.a_kind == CURVE_A_GENERIC)
+            M = AddMod(M,MulMod(E.a % p,fsqr(fsqr(b.Z)),p),p);
+        X3 = SubMod(fsqr(M),AddMod(D,D,p),p);
+        Y3 = SubMod(fmul(M,SubMod(D,X3,p)),MulMod(C,8,p),p);
+        Z3 = fmul(b.Y,b.Z);
+        Z3 = AddMod(Z3,Z3,p);
+    }
+    a.X = X3;
+    a.Y = Y3;
+    a.Z = Z3;
+}
+
+// C = A + B (add-2007-bl)
+void jacobian_add(jpoint& c,const jpoint& a,const jpoint& b)
+{
+    const ZZ& p = E.p;
+    if(IsZero(a.Z))
+    {
+        c = b;
+        return;
+    }
+    if(IsZero(b.Z))
+    {
+        c = a;
+        return;
+    }
+    ZZ Z1Z1 = fsqr(a.Z);
+    ZZ Z2Z2 = fsqr(b.Z);
+    ZZ U1 = fmul(a.X,Z2Z2);
+    ZZ U2 = fmul(b.X,Z1Z1);
+    ZZ S1 = fmul(a.Y,fmul(b.Z,Z2Z2));
+    ZZ S2 = fmul(b.Y,fmul(a.Z,Z1Z1));
+    ZZ H = SubMod(U2,U1,p);
+    ZZ r = SubMod(S2,S1,p);
+    if(IsZero(H))
+    {
+        if(IsZero(r)) jacobian_double(c,a);
+        else clear(c.Z);
+        return;
+    }
+    r = AddMod(r,r,p);
+    ZZ I = fsqr(AddMod(H,H,p));
+    ZZ J = fmul(H,I);
+    ZZ V = fmul(U1,I);
+    ZZ X3 = SubMod(SubMod(SubMod(fsqr(r),J,p),V,p),V,p);
+    ZZ t = fmul(S1,J);
+    ZZ Y3 = SubMod(fmul(r,SubMod(V,X3,p)),AddMod(t,t,p),p);
+    ZZ Z3 = fmul(SubMod(SubMod(fsqr(AddMod(a.Z,b.Z,p)),Z1Z1,p),Z2Z2,p),H);
+    c.X = X3;
+    c.Y = Y3;
+    c.Z = Z3;
+}
+
+// C = A + B voi B affine (madd-2007-bl): 7M + 4S thay vi 11M + 5S
+void jacobian_add_affine(jpoint& c,const jpoint& a,const point& b)
+{
+    const ZZ& p = E.p;
+    if(b.inf)
+    {
+        c = a;
+        return;
+    }
+    if(IsZero(a.Z))
+    {
+        to_jacobian(c,b);
+        return;
+    }
+    ZZ Z1Z1 = fsqr(a.Z);
+    ZZ U2 = MulMod(b.x,Z1Z1,p);
+    ZZ S2 = MulMod(b.y,fmul(a.Z,Z1Z1),p);
+    ZZ H = SubMod(U2,a.X,p);
+    ZZ r = SubMod(S2,a.Y,p);
+    if(IsZero(H))
+    {
+        if(IsZero(r)) jacobian_double(c,a);
+        else clear(c.Z);
+        return;
+    }
+    r = AddMod(r,r,p);
+    ZZ HH = fsqr(H);
+    ZZ I = AddMod(HH,HH,p);
+    I = AddMod(I,I,p);
+    ZZ J = fmul(H,I);
+    ZZ V = fmul(a.X,I);
+    ZZ X3 = SubMod(SubMod(SubMod(fsqr(r),J,p),V,p),V,p);
+    ZZ t = fmul(a.Y,J);
+    ZZ Y3 = SubMod(fmul(r,SubMod(V,X3,p)),AddMod(t,t,p),p);
+    ZZ Z3 = SubMod(SubMod(fsqr(AddMod(a.Z,H,p)),Z1Z1,p),HH,p);
+    c.X = X3;
+    c.Y = Y3;
+    c.Z = Z3;
+}
+
+// Chuan hoa count diem ve affine voi mot phep nghich dao (Montgomery):
+// pre[i] = Z_0...Z_i, nghich dao pre[n-1] roi lan nguoc lai de tach tung Z_i^-1
+void batch_to_affine(point* a,const jpoint* b,long count)
+{
+    const ZZ& p = E.p;
+    std::vector<ZZ> pre(count),z(count);
+    ZZ acc;
+    set(acc);
+    for(long i = 0; i < count; i++)
+    {
+        z[i] = from_field(b[i].Z);
+        if(!IsZero(z[i])) acc = MulMod(acc,z[i],p);
+        pre[i] = acc;
+    }
+    ZZ inv = InvMod(acc,p);
+    for(long i = count - 1; i >= 0; i--)
+    {
+        if(IsZero(z[i]))
+        {
+            a[i].inf = true;
+            continue;
+        }
+        ZZ zi = i > 0 ? MulMod(inv,pre[i-1],p) : inv;
+        inv = MulMod(inv,z[i],p);
+        ZZ zi2 = SqrMod(zi,p);
+        a[i].x = fmul(b[i].X,zi2);
+        a[i].y = fmul(b[i].Y,MulMod(zi2,zi,p));
+        a[i].inf = false;
+    }
+}
+
+void copy_point(point& a,point b)
+{
+    a.x = b.x;
+    a.y = b.y;
+    a.inf = b.inf;
+}
+
+
+bool cmp_point(point a,point b)
+{
+    if(a.inf == b.inf && a.x == b.x && a.y == b.y)
+        return true;
+    else
+        return false;
+}
+
+void inv_point(point& a,point b)
+{
+    a.inf = b.inf;
+    if(!a.inf)
+    {
+        a.x = b.x;
+        a.y = -b.y;
+    }
+}
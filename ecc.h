@@ -0,0 +1,93 @@
+#ifndef ECC_H
+#define ECC_H
+
+#include <NTL/ZZ.h>
+#include <NTL/ZZ_p.h>
+
+using namespace NTL;
+
+struct point_s
+{
+    ZZ x;
+    ZZ y;
+    bool inf;
+};
+
+typedef struct point_s point;
+
+// Diem Jacobian (X/Z^2, Y/Z^3), Z = 0 la diem vo cuc; toa do o mien Montgomery cua
+// E.red, chi dung qua cac ham jacobian_* / to_affine / batch_to_affine
+struct jpoint_s
+{
+    ZZ X;
+    ZZ Y;
+    ZZ Z;
+};
+
+typedef struct jpoint_s jpoint;
+
+// dang cua he so a, chon cong thuc nhan doi
+#define CURVE_A_GENERIC 0
+#define CURVE_A_MINUS_3 1
+#define CURVE_A_ZERO 2
+
+struct curve_s
+{
+    ZZ p;
+    ZZ a;
+    ZZ b;
+    point G;
+    ZZ n;
+    ZZ h;
+    int a_kind;     // curve_a_kind(E), dat khi dang ky duong cong
+    // dat cung luc boi curve_field_init; red rong la chua dat (dung MulMod)
+    SmartPtr<ZZ_ReduceStructAdapter> red;   // rut gon mod p cho toa do Jacobian
+    ZZ_pContext fp;                         // ZZ_p mod p (curvep.h)
+    ZZ_pContext fn;                         // ZZ_p mod n
+    SmartPtr<ZZ_PowerModStruct> sqrt_pw;    // luy thua co dinh cua sqrt_mod
+};
+
+typedef struct curve_s curve;
+
+struct signature_s
+{
+    ZZ r;
+    ZZ s;
+};
+
+typedef struct signature_s signature;
+
+// so byte toi da cua digest dua vao bits2int (SHA-512)
+#define MAX_BITS2INT_BYTES 64
+
+extern curve E;
+
+int curve_a_kind(const curve& E);
+void curve_field_init(curve& E);
+bool sqrt_mod(ZZ& r,const ZZ& a,const ZZ& p);
+// nhu tren voi p = E.p, dung luy thua dung san cua E
+bool sqrt_mod(ZZ& r,const ZZ& a,const curve& E);
+bool is_on_curve(const point& P,const curve& E);
+
+void bits2int(ZZ& m,const unsigned char* h,long len,const ZZ& n);
+void ecdsa_sign(signature& sig,const ZZ& d,const ZZ& m);
+bool ecdsa_verify(const point& Q,const signature& sig,const ZZ& m);
+// ok[i] = ecdsa_verify(Q[i],sig[i],m[i]), cac phep nhan diem tinh theo lo; lo lon
+// duoc chia cho cac luong cua GetThreadPool()
+void ecdsa_verify_batch(bool* ok,const point* Q,const signature* sig,const ZZ* m,long count);
+
+void double_point(point& a,point b);
+void add_point(point& c,point a,point b);
+void multi_point(point& a,ZZ k,point b);
+void inv_point(point& a,point b);
+void copy_point(point& a,point b);
+bool cmp_point(point a,point b);
+
+void to_jacobian(jpoint& a,const point& b);
+void to_affine(point& a,const jpoint& b);
+void jacobian_double(jpoint& a,const jpoint& b);
+void jacobian_add(jpoint& c,const jpoint& a,const jpoint& b);
+void jacobian_add_affine(jpoint& c,const jpoint& a,const point& b);
+void batch_to_affine(point* a,const jpoint* b,long count);
+
+#endif
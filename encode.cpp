@@ -0,0 +1,78 @@
+#include <NTL/ZZ.h>
+#include "convert.h"
+#include "encode.h"
+
+using namespace NTL;
+
+long field_size(const curve& E)
+{
+    return (NumBits(E.p) + 7)/8;
+}
+
+long scalar_size(const curve& E)
+{
+    return (NumBits(E.n) + 7)/8;
+}
+
+void encode_scalar(unsigned char* out,const ZZ& k,long len)
+{
+    conv_ZZ_to_bytes(out,k,len);
+}
+
+void decode_scalar(ZZ& k,const unsigned char* in,long len)
+{
+    conv_bytes_to_ZZ(k,in,len);
+}
+
+void encode_point(unsigned char* out,const point& P,long len)
+{
+    conv_ZZ_to_bytes(out,P.x,len);
+    conv_ZZ_to_bytes(out + len,P.y,len);
+}
+
+void decode_point(point& P,const unsigned char* in,long len)
+{
+    conv_bytes_to_ZZ(P.x,in,len);
+    conv_bytes_to_ZZ(P.y,in + len,len);
+    P.inf = false;
+}
+
+void encode_point_compressed(unsigned char* out,const point& P,long len)
+{
+    out[0] = IsOdd(P.y) ? 0x03 : 0x02;
+    conv_ZZ_to_bytes(out + 1,P.x,len);
+}
+
+// y^2 = x^3 + ax + b, chon y theo bit chan/le trong byte dau
+bool decode_point_compressed(point& P,const unsigned char* in,const curve& E)
+{
+    if(in[0] != 0x02 && in[0] != 0x03) return false;
+
+    const ZZ& p = E.p;
+    ZZ x,y,rhs;
+    conv_bytes_to_ZZ(x,in + 1,field_size(E));
+    if(x >= p) return false;
+    rhs = (MulMod(SqrMod(x,p),x,p) + MulMod(E.a % p,x,p) + E.b) % p;
+    if(!sqrt_mod(y,rhs,E)) return false;
+    if(IsOdd(y) != (in[0] == 0x03))
+    {
+        if(IsZero(y)) return false;
+        y = p - y;
+    }
+    P.x = x;
+    P.y = y;
+    P.inf = false;
+    return true;
+}
+
+void encode_signature(unsigned char* out,const signature& sig,long len)
+{
+    conv_ZZ_to_bytes(out,sig.r,len);
+    conv_ZZ_to_bytes(out + len,sig.s,len);
+}
+
+void decode_signature(signature& sig,const unsigned char* in,long len)
+{
+    conv_bytes_to_ZZ(sig.r,in,len);
+    conv_bytes_to_ZZ(sig.s,in + len,len);
+}
@@ -0,0 +1,27 @@
+#ifndef ENCODE_H
+#define ENCODE_H
+
+#include "ecc.h"
+
+// Dinh dang nhi phan co do dai co dinh (big-endian, SEC1):
+//   so nguyen mod n : scalar_size(E) byte
+//   diem tho        : X || Y, 2*field_size(E) byte
+//   diem nen        : 02|03 || X, field_size(E) + 1 byte
+//   chu ky          : r || s, 2*scalar_size(E) byte
+// Ham decode doc truc tiep tu buffer (vd. file da mmap), khong cap phat.
+
+long field_size(const curve& E);
+long scalar_size(const curve& E);
+
+void encode_scalar(unsigned char* out,const ZZ& k,long len);
+void decode_scalar(ZZ& k,const unsigned char* in,long len);
+
+void encode_point(unsigned char* out,const point& P,long len);
+void decode_point(point& P,const unsigned char* in,long len);
+void encode_point_compressed(unsigned char* out,const point& P,long len);
+bool decode_point_compressed(point& P,const unsigned char* in,const curve& E);
+
+void encode_signature(unsigned char* out,const signature& sig,long len);
+void decode_signature(signature& sig,const unsigned char* in,long len);
+
+#endif
@@ -0,0 +1,186 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "convert.h"
+#include "encode.h"
+#include "sha.h"
+#include "curves.h"
+#include "keystore.h"
+
+static const char keystore_magic[8] = {'E','C','D','S','A','K','S','1'};
+
+void key_id(unsigned char* id,const point& Q,long fs)
+{
+    unsigned char buf[2*MAX_BITS2INT_BYTES];
+    encode_point(buf,Q,fs);
+    hash_buffer(buf,2*fs,SHA_256,id);
+}
+
+static unsigned long long bucket_of(const unsigned char* id,unsigned long long bucket_count)
+{
+    return conv_le_to_ull(id,8) & (bucket_count - 1);
+}
+
+bool keystore_open(keystore& ks,const char* path)
+{
+    memset(&ks,0,sizeof(ks));
+    if(!map_file(path,ks.map)) return false;
+    const unsigned char* h = ks.map.data;
+    if(ks.map.size < 128 || memcmp(h,keystore_magic,8) != 0 || conv_le_to_ull(h + 8,4) != KEYSTORE_VERSION)
+    {
+        keystore_close(ks);
+        return false;
+    }
+    ks.flags = (unsigned int)conv_le_to_ull(h + 12,4);
+    ks.scalar_len = (unsigned int)conv_le_to_ull(h + 16,4);
+    ks.point_len = (unsigned int)conv_le_to_ull(h + 20,4);
+    ks.extra_len = (unsigned int)conv_le_to_ull(h + 24,4);
+    ks.record_size = (unsigned int)conv_le_to_ull(h + 28,4);
+    ks.bucket_count = conv_le_to_ull(h + 32,8);
+    ks.record_count = conv_le_to_ull(h + 40,8);
+
+    // bucket_count phai la luy thua cua 2; kich thuoc so voi map.size truoc khi nhan
+    unsigned long long pub = (ks.flags & KEYSTORE_PUB) ? ks.point_len : 0;
+    unsigned long long need = (unsigned long long)KEYSTORE_ID_LENGTH + ks.scalar_len + pub + ks.extra_len;
+    unsigned long long rest = ks.map.size - 128;
+    bool ok = ks.bucket_count != 0 && (ks.bucket_count & (ks.bucket_count - 1)) == 0;
+    ok = ok && ks.record_count < ks.bucket_count;
+    ok = ok && ks.record_size >= need && ks.point_len % 2 == 0;
+    ok = ok && ks.bucket_count <= rest/8;
+    if(ok) rest -= 8*ks.bucket_count;
+    ok = ok && ks.record_count <= rest/ks.record_size;
+    if(!ok)
+    {
+        keystore_close(ks);
+        return false;
+    }
+    ks.curve_id = h + 48;
+    ks.index = h + 128;
+    ks.records = ks.index + 8*ks.bucket_count;
+    return true;
+}
+
+const unsigned char* keystore_find(const keystore& ks,const unsigned char* id)
+{
+    unsigned long long mask = ks.bucket_count - 1;
+    unsigned long long b = bucket_of(id,ks.bucket_count);
+    for(unsigned long long n = 0; n < ks.bucket_count; n++, b = (b + 1) & mask)
+    {
+        unsigned long long slot = conv_le_to_ull(ks.index + 8*b,8);
+        if(slot == 0 || slot > ks.record_count) return 0;
+        const unsigned char* rec = ks.records + (slot - 1)*ks.record_size;
+        if(memcmp(rec,id,KEYSTORE_ID_LENGTH) == 0) return rec;
+    }
+    return 0;
+}
+
+// Q chi co khi kho luu khoa cong khai, neu khong Q.inf = true
+bool keystore_get(const keystore& ks,const unsigned char* rec,ZZ& d,point& Q)
+{
+    const unsigned char* p = rec + KEYSTORE_ID_LENGTH;
+    decode_scalar(d,p,ks.scalar_len);
+    if(ks.flags & KEYSTORE_PUB)
+    {
+        decode_point(Q,p + ks.scalar_len,ks.point_len/2);
+        return true;
+    }
+    Q.inf = true;
+    return false;
+}
+
+const unsigned char* keystore_extra(const keystore& ks,const unsigned char* rec)
+{
+    if(ks.extra_len == 0) return 0;
+    long pub = (ks.flags & KEYSTORE_PUB) ? ks.point_len : 0;
+    return rec + KEYSTORE_ID_LENGTH + ks.scalar_len + pub;
+}
+
+void keystore_close(keystore& ks)
+{
+    unmap_file(ks.map);
+    ks.curve_id = 0;
+    ks.index = 0;
+    ks.records = 0;
+}
+
+bool keystore_create(const char* path,const ZZ* keys,long count,unsigned int flags,
+                     const unsigned char* extra,unsigned int extra_len,unsigned char* ids)
+{
+    long ss = scalar_size(E);
+    long fs = field_size(E);
+    long pub = (flags & KEYSTORE_PUB) ? 2*fs : 0;
+    unsigned long long record_size = (KEYSTORE_ID_LENGTH + ss + pub + extra_len + 7) & ~7ULL;
+    unsigned long long bucket_count = 16;
+    while(bucket_count < 2*(unsigned long long)count) bucket_count <<= 1;
+
+    unsigned long long size = 128 + 8*bucket_count + count*record_size;
+    unsigned char* buf = (unsigned char*)calloc(size,1);
+    if(!buf) return false;
+
+    unsigned char* h = buf;
+    memcpy(h,keystore_magic,8);
+    conv_ull_to_le(h + 8,KEYSTORE_VERSION,4);
+    conv_ull_to_le(h + 12,flags,4);
+    conv_ull_to_le(h + 16,ss,4);
+    conv_ull_to_le(h + 20,2*fs,4);
+    conv_ull_to_le(h + 24,extra_len,4);
+    conv_ull_to_le(h + 28,record_size,4);
+    conv_ull_to_le(h + 32,bucket_count,8);
+    if(curve_active) memcpy(h + 48,curve_active->fingerprint,CURVE_FINGERPRINT_LENGTH);
+
+    unsigned char* index = buf + 128;
+    unsigned char* records = index + 8*bucket_count;
+    unsigned long long stored = 0;
+    // khoa cong khai tinh theo lo
+    std::vector<ZZ> d(count);
+    std::vector<point> Q(count);
+    for(long i = 0; i < count; i++)
+    {
+        d[i] = keys[i] % E.n;
+        // d = 0 (mod n) cho Q o vo cuc, khong ky duoc
+        if(IsZero(d[i]))
+        {
+            free(buf);
+            return false;
+        }
+    }
+    if(count) multi_point_G_batch(&Q[0],&d[0],count);
+    for(long i = 0; i < count; i++)
+    {
+        unsigned char* rec = records + stored*record_size;
+        key_id(rec,Q[i],fs);
+        if(ids) memcpy(ids + i*KEYSTORE_ID_LENGTH,rec,KEYSTORE_ID_LENGTH);
+
+        // bo qua khoa trung
+        unsigned long long mask = bucket_count - 1;
+        unsigned long long b = bucket_of(rec,bucket_count);
+        bool dup = false;
+        for(;; b = (b + 1) & mask)
+        {
+            unsigned long long slot = conv_le_to_ull(index + 8*b,8);
+            if(slot == 0) break;
+            if(memcmp(records + (slot - 1)*record_size,rec,KEYSTORE_ID_LENGTH) == 0)
+            {
+                dup = true;
+                break;
+            }
+        }
+        if(dup) continue;
+
+        unsigned char* p = rec + KEYSTORE_ID_LENGTH;
+        encode_scalar(p,d[i],ss);
+        if(pub) encode_point(p + ss,Q[i],fs);
+        if(extra_len) memcpy(p + ss + pub,extra + i*extra_len,extra_len);
+        stored++;
+        conv_ull_to_le(index + 8*b,stored,8);
+    }
+    conv_ull_to_le(h + 40,stored,8);
+
+    size = 128 + 8*bucket_count + stored*record_size;
+    FILE* file = fopen(path,"wb");
+    bool ok = file && fwrite(buf,1,size,file) == size;
+    if(file) ok = (fclose(file) == 0) && ok;
+    free(buf);
+    return ok;
+}
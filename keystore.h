@@ -0,0 +1,58 @@
+#ifndef KEYSTORE_H
+#define KEYSTORE_H
+
+#include "ecc.h"
+#include "mapfile.h"
+
+// Kho khoa bi mat, doc bang mmap, tra cuu O(1) theo ma khoa.
+//
+//   header 128 byte (little-endian):
+//     0  "ECDSAKS1"      8  version       12 flags          16 scalar_len
+//     20 point_len       24 extra_len     28 record_size    32 bucket_count
+//     40 record_count    48 dau van tay duong cong (32 byte, 0 = khong ro)
+//     80..127 du tru
+//   bang bam: bucket_count o u64 (so thu tu ban ghi + 1, 0 = trong),
+//             do tuyen tinh, he so tai <= 1/2
+//   ban ghi (record_size byte, can le 8):
+//     id[32] | d[scalar_len] | Q[point_len] (neu KEYSTORE_PUB) | extra[extra_len]
+//
+// Ma khoa = SHA-256(X || Y) cua khoa cong khai. Tra cuu chi cham vao mot
+// o bang bam va mot ban ghi, khong phu thuoc so khoa trong kho.
+
+#define KEYSTORE_VERSION 1
+#define KEYSTORE_ID_LENGTH 32
+#define KEYSTORE_PUB 1
+
+struct keystore_s
+{
+    mapped_file map;
+    unsigned int flags;
+    unsigned int scalar_len;
+    unsigned int point_len;
+    unsigned int extra_len;
+    unsigned int record_size;
+    unsigned long long bucket_count;
+    unsigned long long record_count;
+    const unsigned char* curve_id;
+    const unsigned char* index;
+    const unsigned char* records;
+};
+
+typedef struct keystore_s keystore;
+
+void key_id(unsigned char* id,const point& Q,long fs);
+
+bool keystore_open(keystore& ks,const char* path);
+const unsigned char* keystore_find(const keystore& ks,const unsigned char* id);
+bool keystore_get(const keystore& ks,const unsigned char* rec,ZZ& d,point& Q);
+const unsigned char* keystore_extra(const keystore& ks,const unsigned char* rec);
+void keystore_close(keystore& ks);
+
+// Tao kho tu count khoa bi mat (khoa cong khai tinh bang E hien tai); false neu
+// co khoa chia het cho n.
+// extra (co the 0) gom count * extra_len byte du lieu tinh truoc cho tung khoa.
+// ids (co the 0) nhan count * KEYSTORE_ID_LENGTH byte ma khoa theo thu tu keys.
+bool keystore_create(const char* path,const ZZ* keys,long count,unsigned int flags,
+                     const unsigned char* extra,unsigned int extra_len,unsigned char* ids);
+
+#endif
@@ -1,47 +1,31 @@
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <cstdlib>
 #include <NTL/ZZ.h>
+#include <NTL/BasicThreadPool.h>
 #include "convert.h"
 #include "sha.h"
+#include "ecc.h"
+#include "curves.h"
+#include "encode.h"
+#include "corpus.h"
+#include "keystore.h"
+#include "cpu.h"
+#include <vector>
+#include <map>
+#include <string>
 
 using namespace std;
 using namespace NTL;
 
-struct point_s
-{
-    ZZ x;
-    ZZ y;
-    bool inf;
-};
-
-typedef struct point_s point;
-
-struct curve_s
-{
-    ZZ p;
-    ZZ a;
-    ZZ b;
-    point G;
-    ZZ n;
-    ZZ h;
-};
-
-typedef struct curve_s curve;
-
-struct signature_s
-{
-    ZZ r;
-    ZZ s;
-};
-
-typedef struct signature_s signature;
-
-static curve E;
 static ZZ privateKey;
 static point publicKey;
 static signature sig;
-static char* data;
+static unsigned char* data;
+static long dataLen;
+static hash_alg hashAlg = SHA_256;
+static char* tablePath = 0;
 
 
 void print_point(point P)
@@ -52,10 +36,11 @@ void print_point(point P)
     }
     else
     {
-        char* temp = (char*)malloc(65);
-        conv_ZZ_to_hex(temp,P.x,64);
+        long len = 2*field_size(E);
+        char* temp = (char*)malloc(len + 1);
+        conv_ZZ_to_hex(temp,P.x,len);
         cout<<"x = "<<temp<<endl;
-        conv_ZZ_to_hex(temp,P.y,64);
+        conv_ZZ_to_hex(temp,P.y,len);
         cout<<"y = "<<temp<<endl;
         free(temp);
     }
@@ -63,12 +48,14 @@ void print_point(point P)
 
 void print_curve(curve E)
 {
-    char* temp = (char*)malloc(65);
-    conv_ZZ_to_hex(temp,E.p,64);
+    long len = 2*field_size(E);
+    char* temp = (char*)malloc(len + 1);
+    if(curve_active && curve_active->name) cout<<"Duong cong "<<curve_active->name<<endl;
+    conv_ZZ_to_hex(temp,E.p,len);
     cout<<"p = "<<temp<<endl;
     cout<<"E: y^2 = x^3 + "<<E.a<<"*x + "<<E.b<<endl;
     print_point(E.G);
-    conv_ZZ_to_hex(temp,E.n,64);
+    conv_ZZ_to_hex(temp,E.n,2*scalar_size(E));
     cout<<"n = "<<temp<<endl;
     cout<<"h = "<<E.h<<endl;
     free(temp);
@@ -76,8 +63,9 @@ void print_curve(curve E)
 
 void print_privateKey()
 {
-    char* temp = (char*)malloc(65);
-    conv_ZZ_to_hex(temp,privateKey,64);
+    long len = 2*scalar_size(E);
+    char* temp = (char*)malloc(len + 1);
+    conv_ZZ_to_hex(temp,privateKey,len);
     cout<<"primary key = "<<temp<<endl;
     free(temp);
 }
@@ -92,28 +80,53 @@ void print_publicKey()
 void print_signature()
 {
     cout<<"Signature :"<<endl;
-    char* temp = (char*)malloc(65);
-    conv_ZZ_to_hex(temp,sig.r,64);
+    long len = 2*scalar_size(E);
+    char* temp = (char*)malloc(len + 1);
+    conv_ZZ_to_hex(temp,sig.r,len);
     cout<<"r = "<<temp<<endl;
-    conv_ZZ_to_hex(temp,sig.s,64);
+    conv_ZZ_to_hex(temp,sig.s,len);
     cout<<"s = "<<temp<<endl;
     free(temp);
 }
 
 void print_data()
 {
-    cout<<"Data: "<<data<<endl;
+    char temp[2*MAX_DIGEST_LENGTH+1];
+    conv_bytes_to_hex(temp,data,dataLen);
+    cout<<"Data ("<<hash_name(hashAlg)<<"): "<<temp<<endl;
 }
 
 void ECDSA();
 void TaoKhoa();
 void Ky();
 void XacThuc();
+void KyTangDan();
+void ChonHamBam();
+void ChonHamBam()
+{
+    char name[20];
+    hash_alg alg;
+    cout<<"Ham bam (sha256, sha384, sha512, sha512-256): "<<endl;
+    cin>>name;
+    cin.ignore();
+    if(hash_from_name(name,alg)) hashAlg = alg;
+    else cout<<"Ham bam khong ho tro"<<endl;
+}
+
+int KyLuong(char* curvePath,char* keyPath,char* sigPath,char* dataPath);
+int XacThucLuong(char* curvePath,char* keyPath,char* sigPath,char* dataPath);
+int TaoLo(char* curvePath,char* corpusPath,char* listPath);
+int XacThucLo(char* curvePath,char* corpusPath);
+int TaoKho(char* curvePath,char* storePath,char* listPath);
+int KyKho(char* curvePath,char* storePath,char* idHex,char* sigPath,char* dataPath);
+int TaoBang(char* curvePath,char* tablePath);
 
 bool load_curve(char* path);
 bool load_privateKey(char* path);
 bool load_publicKey(char* path);
 bool load_data(char* path);
+bool load_data_resume(char* path,char* statePath);
+void digest_to_ZZ(ZZ& m);
 bool load_signature(char* path);
 
 bool save_privateKey(char* path);
@@ -124,19 +137,114 @@ bool compute_publicKey();
 bool generate_signature();
 bool check_signature();
 
-void double_point(point& a,point b);
-void add_point(point& c,point a,point b);
-void multi_point(point& a,ZZ k,point b);
-void inv_point(point& a,point b);
-void copy_point(point& a,point b);
-bool cmp_point(point a,point b);
-
-int main()
+// ECDSA [-bam ten] ky <duong cong> <khoa bi mat> <chu ky> [du lieu]
+// ECDSA [-bam ten] xacthuc <duong cong> <khoa cong khai> <chu ky> [du lieu]
+// du lieu: duong dan, "-" la stdin (mac dinh), "fd:N" la file descriptor N
+// ten: sha256 (mac dinh), sha384, sha512, sha512-256
+// ECDSA [-bam ten] taolo <duong cong> <kho chu ky> <danh sach>
+// ECDSA xacthuclo <duong cong> <kho chu ky|->
+// danh sach: moi dong "<khoa cong khai> <chu ky> <du lieu>"
+// ECDSA taokho <duong cong> <kho khoa> <danh sach khoa bi mat>
+// ECDSA [-bam ten] kykho <duong cong> <kho khoa> <ma khoa> <chu ky> [du lieu]
+// ECDSA taobang <duong cong> <bang G>
+// -bang <bang G>: dung bang G tinh san (mmap) cho moi lenh, ke ca menu; chi ap dung
+//   cho duong cong khong co kernel bien dich san (khong phai P-256, secp256k1)
+// -cpu <generic|adx|ifma>: gioi han tap lenh cho kernel so hoc (mac dinh: theo CPUID)
+// -luong <n>: so luong dung cho xac thuc hang loat va tao khoa theo lo (mac dinh: so luong phan cung)
+int main(int argc,char** argv)
 {
-    data = (char*)malloc(65);
-    ECDSA();
+    int ret = 0;
+    data = (unsigned char*)malloc(MAX_DIGEST_LENGTH);
+    while(argc >= 3 && (strcmp(argv[1],"-bam") == 0 || strcmp(argv[1],"-bang") == 0 || strcmp(argv[1],"-cpu") == 0 ||
+                        strcmp(argv[1],"-luong") == 0))
+    {
+        cpu_level level;
+        if(strcmp(argv[1],"-bang") == 0)
+        {
+            tablePath = argv[2];
+        }
+        else if(strcmp(argv[1],"-luong") == 0)
+        {
+            long n = atol(argv[2]);
+            if(n < 1)
+            {
+                cerr<<"So luong khong hop le: "<<argv[2]<<endl;
+                free(data);
+                return 2;
+            }
+            SetNumThreads(n);
+        }
+        else if(strcmp(argv[1],"-cpu") == 0)
+        {
+            if(!cpu_level_from_name(argv[2],level))
+            {
+                cerr<<"Tap lenh khong ho tro: "<<argv[2]<<endl;
+                free(data);
+                return 2;
+            }
+            cpu_limit(level);
+        }
+        else if(!hash_from_name(argv[2],hashAlg))
+        {
+            cerr<<"Ham bam khong ho tro: "<<argv[2]<<endl;
+            free(data);
+            return 2;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+    if(argc == 4 && strcmp(argv[1],"taobang") == 0)
+    {
+        ret = TaoBang(argv[2],argv[3]);
+    }
+    else if(argc == 4 && strcmp(argv[1],"xacthuclo") == 0)
+    {
+        ret = XacThucLo(argv[2],argv[3]);
+    }
+    else if(argc == 5 && strcmp(argv[1],"taolo") == 0)
+    {
+        ret = TaoLo(argv[2],argv[3],argv[4]);
+    }
+    else if(argc == 5 && strcmp(argv[1],"taokho") == 0)
+    {
+        ret = TaoKho(argv[2],argv[3],argv[4]);
+    }
+    else if((argc == 6 || argc == 7) && strcmp(argv[1],"kykho") == 0)
+    {
+        char stdinPath[] = "-";
+        ret = KyKho(argv[2],argv[3],argv[4],argv[5],argc == 7 ? argv[6] : stdinPath);
+    }
+    else if(argc >= 5 && argc <= 6)
+    {
+        char stdinPath[] = "-";
+        char* dataPath = argc == 6 ? argv[5] : stdinPath;
+        if(strcmp(argv[1],"ky") == 0)
+            ret = KyLuong(argv[2],argv[3],argv[4],dataPath);
+        else if(strcmp(argv[1],"xacthuc") == 0)
+            ret = XacThucLuong(argv[2],argv[3],argv[4],dataPath);
+        else
+            ret = 2;
+    }
+    else if(argc > 1)
+    {
+        cerr<<"Cach dung: "<<argv[0]<<" [-bam ten] ky|xacthuc <duong cong> <khoa> <chu ky> [du lieu|-|fd:N]"<<endl
+            <<"           "<<argv[0]<<" [-bam ten] taolo <duong cong> <kho chu ky> <danh sach>"<<endl
+            <<"           "<<argv[0]<<" xacthuclo <duong cong> <kho chu ky|->"<<endl
+            <<"           "<<argv[0]<<" taokho <duong cong> <kho khoa> <danh sach>"<<endl
+            <<"           "<<argv[0]<<" [-bam ten] kykho <duong cong> <kho khoa> <ma khoa> <chu ky> [du lieu|-|fd:N]"<<endl
+            <<"           "<<argv[0]<<" taobang <duong cong> <bang G>"<<endl
+            <<"Tuy chon -bang <bang G> dat truoc lenh de dung bang G tinh san"<<endl
+            <<"  (chi cho duong cong khong co kernel rieng; P-256, secp256k1 bo qua bang)"<<endl
+            <<"Tuy chon -luong <n> dat so luong cho cac lenh theo lo (mac dinh: so nhan CPU)"<<endl;
+        ret = 2;
+    }
+    else
+    {
+        ECDSA();
+    }
     free(data);
-    return 0;
+    return ret;
 }
 
 void ECDSA()
@@ -148,7 +256,8 @@ void ECDSA()
 
         check = false;
         cout<<"Chon chuc nang"<<endl<<"1.Tao Khoa"<<endl<<"2.Ky len ban tin"<<endl<<"3.Xac thuc chu ky"
-            <<endl<<"4.Ket thuc"<<endl;
+            <<endl<<"4.Ket thuc"<<endl<<"5.Ky tang dan (nhat ky ghi them)"<<endl
+            <<"6.Chon ham bam ("<<hash_name(hashAlg)<<")"<<endl;
         cin>>chon;
         cin.ignore();
         if(strcmp(chon,"1") == 0)
@@ -170,6 +279,16 @@ void ECDSA()
         {
             system("exit");
         }
+        else if(strcmp(chon,"5")== 0)
+        {
+            KyTangDan();
+            check=true;
+        }
+        else if(strcmp(chon,"6")== 0)
+        {
+            ChonHamBam();
+            check=true;
+        }
         else
         {
             check = true;
@@ -293,110 +412,438 @@ LOAD_DATA:
     free(path);
 }
 
-bool load_curve(char* path)
+void KyTangDan()
+{
+    bool success;
+    char *path = (char*)malloc(50);
+    char *statePath = (char*)malloc(50);
+LOAD_E:
+    cout<<"Load duong cong Elliptic: "<<endl;
+    cin>>path;
+    cin.ignore();
+    success = load_curve(path);
+    if(!success) goto LOAD_E;
+    print_curve(E);
+
+LOAD_PRK:
+    cout<<"Load khoa bi mat: "<<endl;
+    cin>>path;
+    cin.ignore();
+    success = load_privateKey(path);
+    if(!success) goto LOAD_PRK;
+    print_privateKey();
+
+LOAD_DATA:
+    cout<<"Load nhat ky: "<<endl;
+    cin>>path;
+    cin.ignore();
+    cout<<"File trang thai bam: "<<endl;
+    cin>>statePath;
+    cin.ignore();
+    success = load_data_resume(path,statePath);
+    if(!success) goto LOAD_DATA;
+    print_data();
+
+    cout<<"Tao chu ky dien tu"<<endl;
+    success = generate_signature();
+    print_signature();
+    cout<<"Luu chu ky dien tu: "<<endl;
+    cin>>path;
+    cin.ignore();
+    success = save_signature(path);
+    free(statePath);
+    free(path);
+}
+
+int KyLuong(char* curvePath,char* keyPath,char* sigPath,char* dataPath)
 {
-    char* temp = (char*)malloc(65);
-    ifstream in;
-    in.open(path);
-    if(!in.is_open())
+    if(!load_curve(curvePath)) return 2;
+    if(!load_privateKey(keyPath)) return 2;
+    if(!load_data(dataPath)) return 2;
+    generate_signature();
+    if(!save_signature(sigPath)) return 2;
+    return 0;
+}
+
+int XacThucLuong(char* curvePath,char* keyPath,char* sigPath,char* dataPath)
+{
+    if(!load_curve(curvePath)) return 2;
+    if(!load_publicKey(keyPath)) return 2;
+    if(!load_signature(sigPath)) return 2;
+    if(!load_data(dataPath)) return 2;
+    if(check_signature())
+    {
+        cout<<"Xac Thuc"<<endl;
+        return 0;
+    }
+    cout<<"Khong xac thuc"<<endl;
+    return 1;
+}
+
+// Gom cac cap (khoa, chu ky, du lieu) trong danh sach vao mot kho dang cot.
+// Lan 1 doc khoa cong khai de lap bang khoa, lan 2 ghi tung ban ghi.
+int TaoLo(char* curvePath,char* corpusPath,char* listPath)
+{
+    if(!load_curve(curvePath)) return 2;
+    long fs = field_size(E);
+    long ss = scalar_size(E);
+    char keyPath[256],sigPath[256],dataPath[256];
+    unsigned char buf[256];
+    map<string,unsigned long> index;
+    string keys;
+
+    FILE* list = fopen(listPath,"r");
+    if(!list)
     {
         cout<<"Khong mo duoc file"<<endl;
-        return false;
+        return 2;
     }
-    else
+    while(fscanf(list,"%255s %255s %255s",keyPath,sigPath,dataPath) == 3)
     {
-        in.getline(temp,65);
-        conv_hex_to_ZZ(E.p,temp);
-        in.getline(temp,65);
-        conv_hex_to_ZZ(E.a,temp);
-        in.getline(temp,65);
-        conv_hex_to_ZZ(E.b,temp);
-        in.getline(temp,65);
-        conv_hex_to_ZZ(E.G.x,temp);
-        in.getline(temp,65);
-        conv_hex_to_ZZ(E.G.y,temp);
-        E.G.inf = false;
-        in.getline(temp,65);
-        conv_hex_to_ZZ(E.n,temp);
-        in.getline(temp,65);
-        conv_hex_to_ZZ(E.h,temp);
-    }
-    in.close();
-    free(temp);
+        if(!load_publicKey(keyPath))
+        {
+            fclose(list);
+            return 2;
+        }
+        encode_point(buf,publicKey,fs);
+        string key((char*)buf,2*fs);
+        if(index.find(key) == index.end())
+        {
+            unsigned long k = index.size();
+            index[key] = k;
+            keys += key;
+        }
+    }
+
+    corpus_writer w;
+    if(!corpus_create(w,corpusPath,hash_length(hashAlg),ss,2*fs,(const unsigned char*)keys.data(),index.size(),
+                      curve_active ? curve_active->fingerprint : 0))
+    {
+        fclose(list);
+        cout<<"Error"<<endl;
+        return 2;
+    }
+    rewind(list);
+    bool ok = true;
+    while(ok && fscanf(list,"%255s %255s %255s",keyPath,sigPath,dataPath) == 3)
+    {
+        ok = load_publicKey(keyPath) && load_signature(sigPath) && load_data(dataPath);
+        if(!ok) break;
+        encode_point(buf,publicKey,fs);
+        unsigned long k = index[string((char*)buf,2*fs)];
+        encode_signature(buf,sig,ss);
+        ok = corpus_append(w,data,buf,buf + ss,k);
+    }
+    fclose(list);
+    ok = corpus_finish(w) && ok;
+    if(!ok) return 2;
+    cout<<w.hdr.record_count<<" chu ky, "<<index.size()<<" khoa"<<endl;
+    return 0;
+}
+
+int XacThucLo(char* curvePath,char* corpusPath)
+{
+    if(!load_curve(curvePath)) return 2;
+    unsigned long long valid,invalid;
+    unsigned long long bad[20];
+    corpus_status st = verify_corpus(corpusPath,valid,invalid,bad,20);
+    if(st == CORPUS_WRONG_CURVE)
+    {
+        cout<<"Kho chu ky duoc tao cho duong cong khac"<<endl;
+        return 2;
+    }
+    if(st != CORPUS_OK)
+    {
+        cout<<"Kho chu ky khong hop le"<<endl;
+        return 2;
+    }
+    cout<<"Xac thuc: "<<valid<<endl<<"Khong xac thuc: "<<invalid<<endl;
+    for(unsigned long long i = 0; i < invalid && i < 20; i++)
+        cout<<"  ban ghi "<<bad[i]<<endl;
+    return invalid == 0 ? 0 : 1;
+}
+
+// Dua cac khoa bi mat trong danh sach vao kho khoa, in ma khoa cua tung khoa
+int TaoKho(char* curvePath,char* storePath,char* listPath)
+{
+    if(!load_curve(curvePath)) return 2;
+    char keyPath[256];
+    vector<ZZ> keys;
+    FILE* list = fopen(listPath,"r");
+    if(!list)
+    {
+        cout<<"Khong mo duoc file"<<endl;
+        return 2;
+    }
+    while(fscanf(list,"%255s",keyPath) == 1)
+    {
+        if(!load_privateKey(keyPath))
+        {
+            fclose(list);
+            return 2;
+        }
+        if(IsZero(privateKey % E.n))
+        {
+            cout<<"Khoa bi mat khong hop le: "<<keyPath<<endl;
+            fclose(list);
+            return 2;
+        }
+        keys.push_back(privateKey);
+    }
+    fclose(list);
+    vector<unsigned char> ids(keys.size()*KEYSTORE_ID_LENGTH);
+    if(keys.empty() || !keystore_create(storePath,&keys[0],keys.size(),KEYSTORE_PUB,0,0,&ids[0]))
+    {
+        cout<<"Error"<<endl;
+        return 2;
+    }
+
+    char hex[2*KEYSTORE_ID_LENGTH+1];
+    for(size_t i = 0; i < keys.size(); i++)
+    {
+        conv_bytes_to_hex(hex,&ids[i*KEYSTORE_ID_LENGTH],KEYSTORE_ID_LENGTH);
+        cout<<hex<<endl;
+    }
+    return 0;
+}
+
+static bool all_zero(const unsigned char* b,long n)
+{
+    for(long i = 0; i < n; i++)
+        if(b[i]) return false;
+    return true;
+}
+
+int KyKho(char* curvePath,char* storePath,char* idHex,char* sigPath,char* dataPath)
+{
+    if(!load_curve(curvePath)) return 2;
+    if(strlen(idHex) != 2*KEYSTORE_ID_LENGTH)
+    {
+        cout<<"Ma khoa khong hop le"<<endl;
+        return 2;
+    }
+    unsigned char id[KEYSTORE_ID_LENGTH];
+    conv_hex_to_bytes(id,idHex,KEYSTORE_ID_LENGTH);
+
+    keystore ks;
+    if(!keystore_open(ks,storePath))
+    {
+        cout<<"Khong mo duoc kho khoa"<<endl;
+        return 2;
+    }
+    const unsigned char* rec = keystore_find(ks,id);
+    if(!rec || (long)ks.scalar_len != scalar_size(E)
+       || (!all_zero(ks.curve_id,CURVE_FINGERPRINT_LENGTH)
+           && memcmp(ks.curve_id,curve_active->fingerprint,CURVE_FINGERPRINT_LENGTH) != 0))
+    {
+        keystore_close(ks);
+        cout<<"Khong tim thay khoa"<<endl;
+        return 2;
+    }
+    keystore_get(ks,rec,privateKey,publicKey);
+    keystore_close(ks);
+
+    if(!load_data(dataPath)) return 2;
+    generate_signature();
+    if(!save_signature(sigPath)) return 2;
+    return 0;
+}
+
+// path: ten duong cong (P-256, secp256k1, P-384, brainpoolP256r1, ...) hoac file
+bool load_curve(char* path)
+{
+    const curve_info* c = curve_open(path);
+    if(!c)
+    {
+        cout<<"Khong mo duoc duong cong"<<endl;
+        return false;
+    }
+    curve_use(c);
+    // duong cong co kernel bien dich san (P-256, secp256k1) tu lap bang G rieng,
+    // khong doc bang mmap nen khong map va kiem tra checksum
+    if(tablePath && c->fast == CURVE256_NONE && c->table == 0 && !curve_table_map(c,tablePath))
+        cout<<"Bang G khong hop le, bo qua"<<endl;
     return true;
 }
 
+int TaoBang(char* curvePath,char* path)
+{
+    if(!load_curve(curvePath)) return 2;
+    if(curve_active->fast != CURVE256_NONE)
+    {
+        cout<<"Duong cong co kernel rieng, khong dung bang G"<<endl;
+        return 2;
+    }
+    if(!curve_table_save(curve_active,path,CURVE_TABLE_WINDOW))
+    {
+        cout<<"Error"<<endl;
+        return 2;
+    }
+    return 0;
+}
+
 bool load_data(char* path)
 {
-    return sha_256(path,data);
+    dataLen = hash_length(hashAlg);
+    if(strcmp(path,"-") == 0)
+        return hash_fd(0,hashAlg,data);
+    if(strncmp(path,"fd:",3) == 0)
+        return hash_fd(atoi(path + 3),hashAlg,data);
+    return hash_file(path,hashAlg,data);
 }
 
-bool load_privateKey(char* path)
+bool load_data_resume(char* path,char* statePath)
+{
+    dataLen = hash_length(hashAlg);
+    return hash_resume(path,statePath,hashAlg,data);
+}
+
+void digest_to_ZZ(ZZ& m)
 {
-    ifstream in;
-    char* temp = (char*) malloc(65);
-    in.open(path);
-    if(!in.is_open())
+    bits2int(m,data,dataLen,E.n);
+}
+
+// Doc ca file (khoa, chu ky deu nho) vao buf, tra ve so byte hoac -1
+static long read_small_file(char* path,unsigned char* buf,long cap)
+{
+    FILE* file = fopen(path,"rb");
+    if(!file)
     {
         cout<<"Khong mo duoc file"<<endl;
-        return false;
+        return -1;
+    }
+    long len = fread(buf,1,cap - 1,file);
+    fclose(file);
+    buf[len] = '\0';
+    return len;
+}
+
+// Tach dong tiep theo trong buffer hex (bo '\r', '\n'), tra ve dau dong
+static char* next_line(char*& cur)
+{
+    char* line = cur;
+    while(*cur && *cur != '\n' && *cur != '\r') cur++;
+    if(*cur)
+    {
+        *cur++ = '\0';
+        if(*cur == '\n') cur++;
+    }
+    return line;
+}
+
+static bool has_suffix(const char* path,const char* ext)
+{
+    long n = strlen(path), m = strlen(ext);
+    return n >= m && strcmp(path + n - m,ext) == 0;
+}
+
+// File khoa/chu ky nhi phan nhan theo duoi ".bin" (khoa cong khai ca ".cbin") nhu
+// khi luu, con lai la hex; kich thuoc chi dung de kiem tra file nhi phan
+static bool bad_binary()
+{
+    cout<<"Kich thuoc file nhi phan khong hop le"<<endl;
+    return false;
+}
+
+bool load_privateKey(char* path)
+{
+    unsigned char buf[512];
+    long len = read_small_file(path,buf,sizeof(buf));
+    if(len < 0) return false;
+    if(has_suffix(path,".bin"))
+    {
+        if(len != scalar_size(E)) return bad_binary();
+        decode_scalar(privateKey,buf,len);
     }
     else
     {
-        in.getline(temp,65);
-        conv_hex_to_ZZ(privateKey,temp);
+        char* cur = (char*)buf;
+        conv_hex_to_ZZ(privateKey,next_line(cur));
     }
-    free(temp);
-    in.close();
     return true;
 }
 
 bool load_publicKey(char* path)
 {
-    char * temp = (char*)malloc(65);
-    ifstream in;
-    in.open(path);
-    if(!in.is_open())
+    unsigned char buf[512];
+    long fs = field_size(E);
+    long len = read_small_file(path,buf,sizeof(buf));
+    if(len < 0) return false;
+    if(!has_suffix(path,".bin") && !has_suffix(path,".cbin"))
     {
-        cout<<"Khong mo duoc file"<<endl;
-        return false;
+        char* cur = (char*)buf;
+        conv_hex_to_ZZ(publicKey.x,next_line(cur));
+        conv_hex_to_ZZ(publicKey.y,next_line(cur));
+        publicKey.inf = false;
     }
-    else
+    else if(len == 2*fs)
     {
-        in.getline(temp,65);
-        conv_hex_to_ZZ(publicKey.x,temp);
-        in.getline(temp,65);
-        conv_hex_to_ZZ(publicKey.y,temp);
+        decode_point(publicKey,buf,fs);
+    }
+    else if(len == 2*fs + 1 && buf[0] == 0x04)
+    {
+        decode_point(publicKey,buf + 1,fs);
+    }
+    else if(len == fs + 1 && (buf[0] == 0x02 || buf[0] == 0x03))
+    {
+        if(!decode_point_compressed(publicKey,buf,E))
+        {
+            cout<<"Khoa cong khai khong hop le"<<endl;
+            return false;
+        }
+    }
+    else return bad_binary();
+    if(!is_on_curve(publicKey,E))
+    {
+        cout<<"Khoa cong khai khong nam tren duong cong"<<endl;
+        return false;
     }
-    free(temp);
-    in.close();
     return true;
 }
 
 bool load_signature(char* path)
 {
-    char *temp = (char*)malloc(65);
-    ifstream in;
-    in.open(path);
-    if(!in.is_open())
+    unsigned char buf[512];
+    long len = read_small_file(path,buf,sizeof(buf));
+    if(len < 0) return false;
+    if(has_suffix(path,".bin"))
     {
-        cout<<"Khong mo duoc file"<<endl;
-        return false;
+        if(len != 2*scalar_size(E)) return bad_binary();
+        decode_signature(sig,buf,len/2);
     }
     else
     {
-        in.getline(temp,65);
-        conv_hex_to_ZZ(sig.r,temp);
-        in.getline(temp,65);
-        conv_hex_to_ZZ(sig.s,temp);
+        char* cur = (char*)buf;
+        conv_hex_to_ZZ(sig.r,next_line(cur));
+        conv_hex_to_ZZ(sig.s,next_line(cur));
     }
-    in.close();
-    free(temp);
     return true;
 }
 
+// Luu nhi phan neu duong dan ket thuc bang ".bin" (khoa cong khai: ".cbin"
+// la dang nen 33 byte), nguoc lai luu hex nhu cu
+static bool save_binary(char* path,const unsigned char* buf,long len)
+{
+    FILE* file = fopen(path,"wb");
+    if(!file)
+    {
+        cout<<"Error"<<endl;
+        return false;
+    }
+    bool ok = (long)fwrite(buf,1,len,file) == len;
+    fclose(file);
+    return ok;
+}
+
 bool save_privateKey(char* path)
 {
+    if(has_suffix(path,".bin"))
+    {
+        unsigned char buf[128];
+        long ss = scalar_size(E);
+        encode_scalar(buf,privateKey,ss);
+        return save_binary(path,buf,ss);
+    }
     ofstream out;
     out.open(path,ios::out|ios::trunc);
     if(!out.is_open())
@@ -406,8 +853,9 @@ bool save_privateKey(char* path)
     }
     else
     {
-        char* a = (char*)malloc(65);
-        conv_ZZ_to_hex(a,privateKey,64);
+        long len = 2*scalar_size(E);
+        char* a = (char*)malloc(len + 1);
+        conv_ZZ_to_hex(a,privateKey,len);
         out<<a;
         free(a);
     }
@@ -417,6 +865,18 @@ bool save_privateKey(char* path)
 
 bool save_publicKey(char* path)
 {
+    if(has_suffix(path,".bin") || has_suffix(path,".cbin"))
+    {
+        unsigned char buf[256];
+        long fs = field_size(E);
+        if(has_suffix(path,".cbin"))
+        {
+            encode_point_compressed(buf,publicKey,fs);
+            return save_binary(path,buf,fs + 1);
+        }
+        encode_point(buf,publicKey,fs);
+        return save_binary(path,buf,2*fs);
+    }
     ofstream out;
     out.open(path,ios::out|ios::trunc);
     if(!out.is_open())
@@ -426,10 +886,11 @@ bool save_publicKey(char* path)
     }
     else
     {
-        char* a = (char*)malloc(65);
-        conv_ZZ_to_hex(a,publicKey.x,64);
+        long len = 2*field_size(E);
+        char* a = (char*)malloc(len + 1);
+        conv_ZZ_to_hex(a,publicKey.x,len);
         out<<a<<endl;
-        conv_ZZ_to_hex(a,publicKey.y,64);
+        conv_ZZ_to_hex(a,publicKey.y,len);
         out<<a<<endl;
         free(a);
     }
@@ -439,6 +900,13 @@ bool save_publicKey(char* path)
 
 bool save_signature(char* path)
 {
+    if(has_suffix(path,".bin"))
+    {
+        unsigned char buf[256];
+        long ss = scalar_size(E);
+        encode_signature(buf,sig,ss);
+        return save_binary(path,buf,2*ss);
+    }
     ofstream out;
     out.open(path,ios::out|ios::trunc);
     if(!out.is_open())
@@ -448,10 +916,11 @@ bool save_signature(char* path)
     }
     else
     {
-        char* a = (char*)malloc(65);
-        conv_ZZ_to_hex(a,sig.r,64);
+        long len = 2*scalar_size(E);
+        char* a = (char*)malloc(len + 1);
+        conv_ZZ_to_hex(a,sig.r,len);
         out<<a<<endl;
-        conv_ZZ_to_hex(a,sig.s,64);
+        conv_ZZ_to_hex(a,sig.s,len);
         out<<a<<endl;
         free(a);
     }
@@ -461,198 +930,21 @@ bool save_signature(char* path)
 
 bool compute_publicKey()
 {
-    ZZ k = privateKey%E.n;
-    multi_point(publicKey,k,E.G);
+    multi_point_G(publicKey,privateKey);
     return true;
 }
 
 bool generate_signature()
 {
-    point Q;
-    ZZ n = E.n;
-
-    //chon k ngau nhien 2 -> n-1
-BUOC_1:
-    ZZ k = RandomLen_ZZ(256)%(n -2) + 2;
-    //Tinh Q = kG (x1,y1)
-    multi_point(Q,k,E.G);
-    //Tinh r = x1 mod n
-    sig.r = Q.x%n;
-    //Neu r = 0 quay lai buoc 1
-    if(sig.r==0) goto BUOC_1;
-    else
-    {
-        //tinh s = k^-1 * (m + d*r) mod n;
-        ZZ m;
-        conv_hex_to_ZZ(m,data);
-        sig.s = MulMod(InvMod(k%n,n),m + privateKey * sig.r,n);
-        if(sig.s == 0) goto BUOC_1;
-    }
+    ZZ m;
+    digest_to_ZZ(m);
+    ecdsa_sign(sig,privateKey,m);
     return true;
 }
 
 bool check_signature()
 {
-    ZZ r = sig.r;
-    ZZ s = sig.s;
-    ZZ n = E.n;
     ZZ m;
-    conv_hex_to_ZZ(m,data);
-    point G,Q;
-    copy_point(G,E.G);
-    copy_point(Q,publicKey);
-
-    if(r>=2 && r<n && s>=2 && s<n)
-    {
-        //Tinh w = s^-1 mod n
-        ZZ w = InvMod(s,n);
-        //Tinh u1 = mw mod n
-        ZZ u1 = MulMod(m,w,n);
-        //tinh u2 = rw mod n
-        ZZ u2 = MulMod(r,w,n);
-
-        point X,X1,X2;
-        // Tinh X = u1*G + u2*Q
-        multi_point(X1,u1,G);
-        multi_point(X2,u2,Q);
-        add_point(X,X1,X2);
-
-        if(X.inf)
-        {
-            return false;
-        }
-        else
-        {
-            ZZ v = X.x%n;
-            if(v==r) return true;
-        }
-    }
-    return false;
-}
-
-//C = A + B
-void add_point(point& c,point a,point b)
-{
-    ZZ p = E.p;
-
-    // neu b = inf thi c = a
-    if(b.inf)
-    {
-        copy_point(c,a);
-    }
-    // neu a = inf thi c = b
-    else if(a.inf)
-    {
-        copy_point(c,b);
-    }
-    //neu a = b thi c = 2*a
-    else if(cmp_point(a,b))
-    {
-        double_point(c,a);
-    }
-    // neu a != b != inf
-    else
-    {
-        point temp;
-        inv_point(temp,a);
-        // new b = -a thi c = inf
-        if(cmp_point(temp,b))
-        {
-            c.inf = true;
-        }
-        // new b!= -a
-        else
-        {
-            // lamda = (yB - yA)/(xB - xA) mod p
-            ZZ lamda;
-            lamda = MulMod((b.y%p - a.y%p),InvMod((b.x%p - a.x%p)%p,p),p);
-            // xC = (lamda^2 - xA -xB) mod p
-            c.x = (power(lamda,2)%p - a.x%p - b.x%p)%p;
-            //yC = lamda*(xA - xC) - yA mod p
-            c.y = (lamda*(a.x%p - c.x%p)%p - a.y%p)%p;
-            c.inf = false;
-        }
-    }
-}
-
-//A = 2B
-void double_point(point& a,point b)
-{
-    ZZ p = E.p;
-    if(b.inf)
-    {
-        a.inf = true;
-    }
-    else if(b.y == 0)
-    {
-        a.inf = true;
-    }
-    else
-    {
-        // lamda = (3*xB^2 + a)/2*yB
-        ZZ lamda;
-        lamda = MulMod((3*power(b.x,2)%p + E.a%p)%p,InvMod(2*b.y%p,p),p);
-        // xC = (lamda^2 - xA -xB) mod p
-        a.x = (power(lamda,2)%p - b.x%p - b.x%p)%p;
-        //yC = lamda*(xA - xC) - yA mod p
-        a.y = (lamda*(b.x%p - a.x%p)%p - b.y%p)%p;
-        a.inf = false;
-    }
-}
-
-//A = kB
-void multi_point(point& a,ZZ k,point b)
-{
-    if(b.inf)
-    {
-        a.inf = true;
-        return;
-    }
-
-    point T0,T1;
-    copy_point(T0,b);
-    copy_point(T1,T0);
-
-    while(k>to_ZZ(1))
-    {
-        if(k%2 == 0)
-        {
-            add_point(T1,T0,T1);
-            double_point(T0,T0);
-            k=k/2;
-
-        }
-        else
-        {
-            double_point(T0,T0);
-            k=k/2 + 1;
-        }
-    }
-    copy_point(a,T1);
-}
-
-void copy_point(point& a,point b)
-{
-    a.x = b.x;
-    a.y = b.y;
-    a.inf = b.inf;
-}
-
-
-bool cmp_point(point a,point b)
-{
-    if(a.inf == b.inf && a.x == b.x && a.y == b.y)
-        return true;
-    else
-        return false;
-}
-
-void inv_point(point& a,point b)
-{
-    a.inf = b.inf;
-    if(!a.inf)
-    {
-        a.x = b.x;
-        a.y = -b.y;
-    }
+    digest_to_ZZ(m);
+    return ecdsa_verify(publicKey,sig,m);
 }
@@ -0,0 +1,81 @@
+#include "mapfile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool map_file(const char* path,mapped_file& m)
+{
+    m.data = 0;
+    m.size = 0;
+    m.handle = 0;
+    HANDLE file = CreateFileA(path,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+    if(file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file,&size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file,NULL,PAGE_READONLY,0,0,NULL);
+    CloseHandle(file);
+    if(!mapping) return false;
+    void* p = MapViewOfFile(mapping,FILE_MAP_READ,0,0,0);
+    if(!p)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    m.data = (const unsigned char*)p;
+    m.size = size.QuadPart;
+    m.handle = mapping;
+    return true;
+}
+
+void unmap_file(mapped_file& m)
+{
+    if(m.data) UnmapViewOfFile(m.data);
+    if(m.handle) CloseHandle((HANDLE)m.handle);
+    m.data = 0;
+    m.size = 0;
+    m.handle = 0;
+}
+
+#else
+
+bool map_file(const char* path,mapped_file& m)
+{
+    m.data = 0;
+    m.size = 0;
+    m.handle = 0;
+    int fd = open(path,O_RDONLY);
+    if(fd < 0) return false;
+    struct stat st;
+    if(fstat(fd,&st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+    void* p = mmap(0,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+    close(fd);
+    if(p == MAP_FAILED) return false;
+    m.data = (const unsigned char*)p;
+    m.size = st.st_size;
+    return true;
+}
+
+void unmap_file(mapped_file& m)
+{
+    if(m.data) munmap((void*)m.data,m.size);
+    m.data = 0;
+    m.size = 0;
+    m.handle = 0;
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+// Anh xa file chi doc vao bo nho (mmap / MapViewOfFile)
+struct mapped_file_s
+{
+    const unsigned char* data;
+    unsigned long long size;
+    void* handle;
+};
+
+typedef struct mapped_file_s mapped_file;
+
+bool map_file(const char* path,mapped_file& m);
+void unmap_file(mapped_file& m);
+
+#endif
@@ -1,69 +1,326 @@
 #include<fstream>
+#include<string>
 #include<cstdlib>
+#include<cstdio>
+#include<cstring>
+#include<cerrno>
 #include <openssl/sha.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#endif
+#include "sha.h"
 
 using namespace std;
 
-bool sha_256(char *path,char* outputBuffer)
+struct hash_ctx_s
+{
+    hash_alg alg;
+    SHA256_CTX sha256;
+    SHA512_CTX sha512;
+};
+
+typedef struct hash_ctx_s hash_ctx;
+
+// IV cua SHA-512/256 (FIPS 180-4, muc 5.3.6.2)
+static const unsigned long long sha512_256_iv[8] =
+{
+    0x22312194FC2BF72CULL, 0x9F555FA3C84C64C2ULL,
+    0x2393B86B6F53B151ULL, 0x963877195940EABDULL,
+    0x96283EE2A88EFFE3ULL, 0xBE5E1E2553863992ULL,
+    0x2B0199FC2C85B8AAULL, 0x0EB72DDC81C52CA2ULL
+};
+
+static const char* hash_names[] = {"sha256","sha384","sha512","sha512-256"};
+
+int hash_length(hash_alg alg)
+{
+    switch(alg){
+        case SHA_256: return SHA256_DIGEST_LENGTH;
+        case SHA_384: return SHA384_DIGEST_LENGTH;
+        case SHA_512: return SHA512_DIGEST_LENGTH;
+        case SHA_512_256: return SHA256_DIGEST_LENGTH;
+        default:
+            return 0;
+    }
+}
+
+const char* hash_name(hash_alg alg)
+{
+    return hash_names[alg];
+}
+
+bool hash_from_name(const char* name,hash_alg& alg)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        if(strcmp(name,hash_names[i]) == 0)
+        {
+            alg = (hash_alg)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void hash_init(hash_ctx& c,hash_alg alg)
+{
+    c.alg = alg;
+    switch(alg){
+        case SHA_256:
+            SHA256_Init(&c.sha256);
+            break;
+        case SHA_384:
+            SHA384_Init(&c.sha512);
+            break;
+        case SHA_512:
+            SHA512_Init(&c.sha512);
+            break;
+        case SHA_512_256:
+            SHA512_Init(&c.sha512);
+            memcpy(c.sha512.h,sha512_256_iv,sizeof(sha512_256_iv));
+            break;
+    }
+}
+
+static void hash_update(hash_ctx& c,const unsigned char* buffer,size_t n)
+{
+    if(c.alg == SHA_256) SHA256_Update(&c.sha256, buffer, n);
+    else SHA512_Update(&c.sha512, buffer, n);
+}
+
+static void hash_final(hash_ctx& c,unsigned char* digest)
+{
+    if(c.alg == SHA_256)
+    {
+        SHA256_Final(digest, &c.sha256);
+    }
+    else if(c.alg == SHA_512_256)
+    {
+        // SHA-512/256 = SHA-512 voi IV rieng, cat lay 32 byte dau
+        unsigned char hash[SHA512_DIGEST_LENGTH];
+        SHA512_Final(hash, &c.sha512);
+        memcpy(digest,hash,SHA256_DIGEST_LENGTH);
+    }
+    else
+    {
+        SHA512_Final(digest, &c.sha512);
+    }
+}
+
+bool hash_buffer(const unsigned char* buffer,long n,hash_alg alg,unsigned char* digest)
+{
+    hash_ctx ctx;
+    hash_init(ctx,alg);
+    hash_update(ctx, buffer, n);
+    hash_final(ctx, digest);
+    return true;
+}
+
+bool hash_file(char *path,hash_alg alg,unsigned char* digest)
 {
     FILE *file = fopen(path, "rb");
     if(!file) return false;
 
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256_CTX sha256;
-    SHA256_Init(&sha256);
+    hash_ctx ctx;
+    hash_init(ctx,alg);
     const int bufSize = 32768;
     unsigned char *buffer = (unsigned char *)malloc(bufSize);
     int bytesRead = 0;
     if(!buffer) return false;
     while((bytesRead = fread(buffer, 1, bufSize, file)))
     {
-        SHA256_Update(&sha256, buffer, bytesRead);
+        hash_update(ctx, buffer, bytesRead);
     }
-    SHA256_Final(hash, &sha256);
+    hash_final(ctx, digest);
+    fclose(file);
+    free(buffer);
+    return true;
+}
 
-    for(int i = 0; i < SHA256_DIGEST_LENGTH; i++)
+// Bam du lieu doc tu mot file descriptor (stdin, pipe, socket...) theo tung
+// khoi 32KB, bo nho dung khong phu thuoc do dai du lieu.
+bool hash_fd(int fd,hash_alg alg,unsigned char* digest)
+{
+#ifdef _WIN32
+    _setmode(fd, _O_BINARY);
+#endif
+    hash_ctx ctx;
+    hash_init(ctx,alg);
+    const int bufSize = 32768;
+    unsigned char *buffer = (unsigned char *)malloc(bufSize);
+    int bytesRead = 0;
+    if(!buffer) return false;
+    while((bytesRead = read(fd, buffer, bufSize)) != 0)
     {
-        sprintf(outputBuffer + (i * 2), "%02x", hash[i]);
+        if(bytesRead < 0)
+        {
+            if(errno == EINTR) continue;
+            free(buffer);
+            return false;
+        }
+        hash_update(ctx, buffer, bytesRead);
     }
-    outputBuffer[64] = '\0';
-    fclose(file);
+    hash_final(ctx, digest);
     free(buffer);
     return true;
 }
 
+// Trang thai giua chung (midstate) chi duoc luu o bien khoi (64 byte voi
+// SHA-256, 128 byte voi ho SHA-512): dong 1 la so byte da bam, dong 2 la 8
+// tu h[] dang hex, dong 3 la ten ham bam. File hong hoac thieu thi bam tu dau;
+// h[] chi bi ghi de sau khi ca 8 tu doc dung.
+static void load_hash_state(char *statePath,hash_ctx& c,hash_alg alg,unsigned long long& offset)
+{
+    hash_init(c,alg);
+    offset = 0;
 
-#include<fstream>
-#include<cstdlib>
-#include <openssl/sha.h>
+    ifstream in;
+    in.open(statePath);
+    if(!in.is_open()) return;
 
-using namespace std;
+    char temp[129];
+    char name[16];
+    unsigned long long n;
+    if(!(in>>n)) return;
+    in.ignore();
+    if(!in.getline(temp,129) || !in.getline(name,16)) return;
+    in.close();
+    if(strcmp(name,hash_name(alg)) != 0) return;
+
+    int wlen = alg == SHA_256 ? 8 : 16;
+    if((int)strlen(temp) != 8*wlen || (int)strspn(temp,"0123456789abcdefABCDEF") != 8*wlen) return;
+    unsigned long long h[8];
+    for(int i = 0; i < 8; i++)
+    {
+        char word[17];
+        memcpy(word,temp + i*wlen,wlen);
+        word[wlen] = '\0';
+        h[i] = strtoull(word,0,16);
+    }
+    if(alg == SHA_256)
+    {
+        if(n % SHA256_CBLOCK != 0) return;
+        for(int i = 0; i < 8; i++) c.sha256.h[i] = (SHA_LONG)h[i];
+        c.sha256.Nl = (SHA_LONG)(n << 3);
+        c.sha256.Nh = (SHA_LONG)(n >> 29);
+    }
+    else
+    {
+        if(n % SHA512_CBLOCK != 0) return;
+        for(int i = 0; i < 8; i++) c.sha512.h[i] = h[i];
+        c.sha512.Nl = n << 3;
+        c.sha512.Nh = n >> 61;
+    }
+    offset = n;
+}
+
+// Ghi ra file tam roi doi ten, de file trang thai cu con nguyen neu ghi loi giua chung
+static bool save_hash_state(char *statePath,const hash_ctx& c,unsigned long long offset)
+{
+    string tmpPath = string(statePath) + ".tmp";
+    ofstream out;
+    out.open(tmpPath.c_str(),ios::out|ios::trunc);
+    if(!out.is_open()) return false;
+
+    char temp[129];
+    for(int i = 0; i < 8; i++)
+    {
+        if(c.alg == SHA_256)
+            sprintf(temp + i*8, "%08x", (unsigned int)c.sha256.h[i]);
+        else
+            sprintf(temp + i*16, "%016llx", (unsigned long long)c.sha512.h[i]);
+    }
+    out<<offset<<endl<<temp<<endl<<hash_name(c.alg)<<endl;
+    out.close();
+    if(out.fail())
+    {
+        remove(tmpPath.c_str());
+        return false;
+    }
+#ifdef _WIN32
+    if(!MoveFileExA(tmpPath.c_str(),statePath,MOVEFILE_REPLACE_EXISTING))
+#else
+    if(rename(tmpPath.c_str(),statePath) != 0)
+#endif
+    {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Vi tri trong file 64 bit ca tren Windows (long chi 32 bit)
+static bool seek64(FILE *file,unsigned long long offset,int whence)
+{
+#ifdef _WIN32
+    return _fseeki64(file,(__int64)offset,whence) == 0;
+#else
+    return fseeko(file,(off_t)offset,whence) == 0;
+#endif
+}
+
+static bool tell64(FILE *file,unsigned long long& offset)
+{
+#ifdef _WIN32
+    __int64 pos = _ftelli64(file);
+#else
+    off_t pos = ftello(file);
+#endif
+    if(pos < 0) return false;
+    offset = (unsigned long long)pos;
+    return true;
+}
 
-bool sha_256(char *path,char* outputBuffer)
+// Bam tiep tu diem kiem tra trong statePath thay vi tu byte 0.
+// Chi dung cho file ghi them (append-only): neu file ngan hon diem kiem tra
+// (bi cat/xoay vong) hoac doi ham bam thi bam lai tu dau.
+bool hash_resume(char *path,char *statePath,hash_alg alg,unsigned char* digest)
 {
     FILE *file = fopen(path, "rb");
     if(!file) return false;
 
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256_CTX sha256;
-    SHA256_Init(&sha256);
+    hash_ctx ctx;
+    unsigned long long offset;
+    load_hash_state(statePath,ctx,alg,offset);
+    if(offset > 0)
+    {
+        unsigned long long size;
+        if(!seek64(file, 0, SEEK_END) || !tell64(file, size) || size < offset)
+        {
+            hash_init(ctx,alg);
+            offset = 0;
+        }
+        if(!seek64(file, offset, SEEK_SET))
+        {
+            fclose(file);
+            return false;
+        }
+    }
+
     const int bufSize = 32768;
     unsigned char *buffer = (unsigned char *)malloc(bufSize);
     int bytesRead = 0;
-    if(!buffer) return false;
-    while((bytesRead = fread(buffer, 1, bufSize, file)))
+    if(!buffer)
     {
-        SHA256_Update(&sha256, buffer, bytesRead);
+        fclose(file);
+        return false;
     }
-    SHA256_Final(hash, &sha256);
-
-    for(int i = 0; i < SHA256_DIGEST_LENGTH; i++)
+    while((bytesRead = fread(buffer, 1, bufSize, file)))
     {
-        sprintf(outputBuffer + (i * 2), "%02x", hash[i]);
+        hash_update(ctx, buffer, bytesRead);
+        offset += bytesRead;
     }
-    outputBuffer[64] = '\0';
     fclose(file);
     free(buffer);
+
+    // h[] chi chua cac khoi da xu ly xong, phan con lai (num byte) se doc lai lan sau
+    unsigned int pending = alg == SHA_256 ? ctx.sha256.num : ctx.sha512.num;
+    save_hash_state(statePath,ctx,offset - pending);
+
+    hash_final(ctx, digest);
     return true;
 }
-
@@ -1 +1,12 @@
-bool sha_256(char *path,char* outputBuffer);
+#define MAX_DIGEST_LENGTH 64
+
+enum hash_alg { SHA_256, SHA_384, SHA_512, SHA_512_256 };
+
+int hash_length(hash_alg alg);
+const char* hash_name(hash_alg alg);
+bool hash_from_name(const char* name,hash_alg& alg);
+
+bool hash_buffer(const unsigned char* buffer,long n,hash_alg alg,unsigned char* digest);
+bool hash_file(char *path,hash_alg alg,unsigned char* digest);
+bool hash_fd(int fd,hash_alg alg,unsigned char* digest);
+bool hash_resume(char *path,char *statePath,hash_alg alg,unsigned char* digest);
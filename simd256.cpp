@@ -0,0 +1,619 @@
+#include <NTL/ZZ.h>
+#include <cstring>
+#include "convert.h"
+#include "simd256.h"
+
+using namespace NTL;
+
+#ifdef SIMD256
+
+#include <immintrin.h>
+
+// Moi ham dung lenh AVX-512 deu mang thuoc tinh nay; cac ham noi bo cung
+// target nen duoc inline vao nhau, phan con lai cua chuong trinh khong doi.
+#define SIMD256_TARGET __attribute__((target("avx512f,avx512ifma")))
+
+typedef __m512i v8;
+
+// Dich bit va gather dang maskz / co nguon 0: ban thuong cua GCC lay nguon tu
+// _mm512_undefined_epi32() nen -Wall bao "may be used uninitialized"
+#define v_srli(a,n) _mm512_maskz_srli_epi64(0xff,(a),(n))
+#define v_slli(a,n) _mm512_maskz_slli_epi64(0xff,(a),(n))
+#define v_srai(a,n) _mm512_maskz_srai_epi64(0xff,(a),(n))
+#define v_srlv(a,n) _mm512_maskz_srlv_epi64(0xff,(a),(n))
+#define v_sllv(a,n) _mm512_maskz_sllv_epi64(0xff,(a),(n))
+#define v_gather64(idx,base) _mm512_mask_i64gather_epi64(_mm512_setzero_si512(),0xff,(idx),(base),8)
+
+static const limb_t mask52 = (1ULL << 52) - 1;
+
+// 8 phan tu truong: l[i] la limb i (52 bit) cua ca 8 lan
+struct vfe
+{
+    v8 l[5];
+};
+
+struct vjpoint
+{
+    vfe X;
+    vfe Y;
+    vfe Z;
+};
+
+struct vapoint
+{
+    vfe x;
+    vfe y;
+};
+
+// Hang so cua p, moi gia tri lap lai tren 8 lan
+struct vfield
+{
+    v8 p[5];
+    v8 pinv;        // -p^-1 mod 2^52
+    v8 mask;        // 2^52 - 1
+    v8 r2[5];       // 2^520 mod p: x*r2 dua x vao dang Montgomery
+    v8 one[5];      // 2^260 mod p: 1 dang Montgomery
+    v8 raw1[5];     // 1: x*raw1 dua x ra khoi dang Montgomery
+    limb_t e[4];    // p - 2, so mu nghich dao Fermat
+};
+
+// Bang affine cua G dang Montgomery 2^260, x[i][j] la limb i cua diem j (j = 0 bo trong)
+struct gtab
+{
+    limb_t wx[5][16];
+    limb_t wy[5][16];
+    limb_t cx[5][16];
+    limb_t cy[5][16];
+};
+
+// 4 limb 64 bit -> 5 limb 52 bit
+static void to_52(limb_t* r,const limb_t* a)
+{
+    r[0] = a[0] & mask52;
+    r[1] = ((a[0] >> 52) | (a[1] << 12)) & mask52;
+    r[2] = ((a[1] >> 40) | (a[2] << 24)) & mask52;
+    r[3] = ((a[2] >> 28) | (a[3] << 36)) & mask52;
+    r[4] = a[3] >> 16;
+}
+
+static void ZZ_to_52(limb_t* r,const ZZ& a)
+{
+    unsigned char buf[32];
+    limb_t t[4];
+    BytesFromZZ(buf,a,32);
+    for(int i = 0; i < 4; i++) t[i] = conv_le_to_ull(buf + 8*i,8);
+    to_52(r,t);
+}
+
+static void limbs_to_ZZ(ZZ& r,const limb_t* a)
+{
+    unsigned char buf[32];
+    for(int i = 0; i < 4; i++) conv_ull_to_le(buf + 8*i,a[i],8);
+    ZZFromBytes(r,buf,32);
+}
+
+SIMD256_TARGET static inline v8 v_set(limb_t a)
+{
+    return _mm512_set1_epi64((long long)a);
+}
+
+template<class P>
+SIMD256_TARGET static vfield make_field()
+{
+    vfield F;
+    limb_t t[5];
+    ZZ p,x;
+    limbs_to_ZZ(p,P::p);
+
+    to_52(t,P::p);
+    for(int i = 0; i < 5; i++) F.p[i] = v_set(t[i]);
+    // p0^-1 mod 2^64 (Newton), roi doi dau va cat ve 52 bit
+    limb_t inv = 1;
+    for(int i = 0; i < 6; i++) inv *= 2 - P::p[0]*inv;
+    F.pinv = v_set((0 - inv) & mask52);
+    F.mask = v_set(mask52);
+
+    x = power2_ZZ(520) % p;
+    ZZ_to_52(t,x);
+    for(int i = 0; i < 5; i++) F.r2[i] = v_set(t[i]);
+    x = power2_ZZ(260) % p;
+    ZZ_to_52(t,x);
+    for(int i = 0; i < 5; i++) F.one[i] = v_set(t[i]);
+    for(int i = 0; i < 5; i++) F.raw1[i] = v_set(i == 0 ? 1 : 0);
+
+    F.e[0] = P::p[0] - 2;
+    for(int i = 1; i < 4; i++) F.e[i] = P::p[i];
+    return F;
+}
+
+template<class P>
+SIMD256_TARGET static const vfield& field()
+{
+    static const vfield F = make_field<P>();
+    return F;
+}
+
+// Lan truyen nho 52 bit tu limb thap len limb cao
+SIMD256_TARGET static inline void v_carry(v8* t,const vfield& F)
+{
+    for(int j = 0; j < 4; j++)
+    {
+        t[j+1] = _mm512_add_epi64(t[j+1],v_srli(t[j],52));
+        t[j] = _mm512_and_si512(t[j],F.mask);
+    }
+}
+
+// r = t mod p voi t da chuan hoa va t < 2p
+SIMD256_TARGET static inline void v_reduce(vfe& r,const v8* t,const vfield& F)
+{
+    v8 d[5];
+    v8 borrow = _mm512_setzero_si512();
+    for(int j = 0; j < 5; j++)
+    {
+        v8 s = _mm512_add_epi64(_mm512_sub_epi64(t[j],F.p[j]),borrow);
+        borrow = v_srai(s,52);
+        d[j] = _mm512_and_si512(s,F.mask);
+    }
+    __mmask8 neg = _mm512_cmplt_epi64_mask(borrow,_mm512_setzero_si512());
+    for(int j = 0; j < 5; j++) r.l[j] = _mm512_mask_blend_epi64(neg,d[j],t[j]);
+}
+
+SIMD256_TARGET static inline void v_add(vfe& r,const vfe& a,const vfe& b,const vfield& F)
+{
+    v8 t[5];
+    for(int j = 0; j < 5; j++) t[j] = _mm512_add_epi64(a.l[j],b.l[j]);
+    v_carry(t,F);
+    v_reduce(r,t,F);
+}
+
+SIMD256_TARGET static inline void v_sub(vfe& r,const vfe& a,const vfe& b,const vfield& F)
+{
+    v8 d[5];
+    v8 borrow = _mm512_setzero_si512();
+    for(int j = 0; j < 5; j++)
+    {
+        v8 s = _mm512_add_epi64(_mm512_sub_epi64(a.l[j],b.l[j]),borrow);
+        borrow = v_srai(s,52);
+        d[j] = _mm512_and_si512(s,F.mask);
+    }
+    // lan am: cong p, nho ra khoi limb cao bu cho phan muon 2^260
+    __mmask8 neg = _mm512_cmplt_epi64_mask(borrow,_mm512_setzero_si512());
+    for(int j = 0; j < 5; j++) d[j] = _mm512_mask_add_epi64(d[j],neg,d[j],F.p[j]);
+    v_carry(d,F);
+    for(int j = 0; j < 5; j++) r.l[j] = d[j];
+    r.l[4] = _mm512_and_si512(r.l[4],F.mask);
+}
+
+// r = a*b/2^260 mod p (Montgomery theo tung limb 52 bit). a, b < p va moi limb
+// < 2^52; cac tong trung gian trong t con duoi 2^58 nen khong tran 64 bit.
+SIMD256_TARGET static inline void v_mul(vfe& r,const vfe& a,const vfe& b,const vfield& F)
+{
+    const v8 zero = _mm512_setzero_si512();
+    v8 t[6] = {zero,zero,zero,zero,zero,zero};
+    for(int i = 0; i < 5; i++)
+    {
+        for(int j = 0; j < 5; j++)
+        {
+            t[j] = _mm512_madd52lo_epu64(t[j],a.l[i],b.l[j]);
+            t[j+1] = _mm512_madd52hi_epu64(t[j+1],a.l[i],b.l[j]);
+        }
+        v8 m = _mm512_madd52lo_epu64(zero,t[0],F.pinv);
+        for(int j = 0; j < 5; j++)
+        {
+            t[j] = _mm512_madd52lo_epu64(t[j],m,F.p[j]);
+            t[j+1] = _mm512_madd52hi_epu64(t[j+1],m,F.p[j]);
+        }
+        // 52 bit thap cua t0 da ve 0
+        t[1] = _mm512_add_epi64(t[1],v_srli(t[0],52));
+        for(int j = 0; j < 5; j++) t[j] = t[j+1];
+        t[5] = zero;
+    }
+    v_carry(t,F);
+    v_reduce(r,t,F);
+}
+
+SIMD256_TARGET static inline void v_sqr(vfe& r,const vfe& a,const vfield& F)
+{
+    v_mul(r,a,a,F);
+}
+
+SIMD256_TARGET static inline void v_const(vfe& r,const v8* c)
+{
+    for(int j = 0; j < 5; j++) r.l[j] = c[j];
+}
+
+SIMD256_TARGET static inline __mmask8 v_is_zero(const vfe& a)
+{
+    v8 o = _mm512_or_si512(_mm512_or_si512(a.l[0],a.l[1]),_mm512_or_si512(a.l[2],a.l[3]));
+    o = _mm512_or_si512(o,a.l[4]);
+    return _mm512_cmpeq_epi64_mask(o,_mm512_setzero_si512());
+}
+
+// r = b o lan co bit k, giu r o lan con lai
+SIMD256_TARGET static inline void v_select(vfe& r,__mmask8 k,const vfe& b)
+{
+    for(int j = 0; j < 5; j++) r.l[j] = _mm512_mask_blend_epi64(k,r.l[j],b.l[j]);
+}
+
+// r = a^(p-2), cua so 4 bit: 256 binh phuong va 64 phep nhan
+SIMD256_TARGET static void v_inv(vfe& r,const vfe& a,const vfield& F)
+{
+    vfe T[16],x;
+    v_const(T[0],F.one);
+    T[1] = a;
+    for(int j = 2; j < 16; j++) v_mul(T[j],T[j-1],a,F);
+    v_const(x,F.one);
+    for(int i = 63; i >= 0; i--)
+    {
+        for(int s = 0; s < 4; s++) v_sqr(x,x,F);
+        int d = (int)(F.e[i/16] >> (4*(i%16))) & 15;
+        if(d) v_mul(x,x,T[d],F);
+    }
+    r = x;
+}
+
+// Cung cong thuc voi Curve<P>::dbl; lan vo cuc cho ket qua rac, nguoi goi theo doi
+// bang mat na rieng
+template<class P>
+SIMD256_TARGET static void v_dbl(vjpoint& r,const vjpoint& a,const vfield& F)
+{
+    vfe X3,Y3,Z3,t1,t2,t3;
+    if(P::a_kind == CURVE_A_MINUS_3)
+    {
+        vfe delta,gamma,beta,alpha;
+        v_sqr(delta,a.Z,F);
+        v_sqr(gamma,a.Y,F);
+        v_mul(beta,a.X,gamma,F);
+        v_sub(t1,a.X,delta,F);
+        v_add(t2,a.X,delta,F);
+        v_mul(t3,t1,t2,F);
+        v_add(alpha,t3,t3,F);
+        v_add(alpha,alpha,t3,F);
+        v_sqr(X3,alpha,F);
+        v_add(t1,beta,beta,F);
+        v_add(t1,t1,t1,F);
+        v_add(t2,t1,t1,F);
+        v_sub(X3,X3,t2,F);
+        v_add(t2,a.Y,a.Z,F);
+        v_sqr(Z3,t2,F);
+        v_sub(Z3,Z3,gamma,F);
+        v_sub(Z3,Z3,delta,F);
+        v_sub(t1,t1,X3,F);
+        v_mul(Y3,alpha,t1,F);
+        v_sqr(t2,gamma,F);
+        v_add(t2,t2,t2,F);
+        v_add(t2,t2,t2,F);
+        v_add(t2,t2,t2,F);
+        v_sub(Y3,Y3,t2,F);
+    }
+    else
+    {
+        vfe A,B,C,D,E;
+        v_sqr(A,a.X,F);
+        v_sqr(B,a.Y,F);
+        v_sqr(C,B,F);
+        v_add(t1,a.X,B,F);
+        v_sqr(t1,t1,F);
+        v_sub(t1,t1,A,F);
+        v_sub(t1,t1,C,F);
+        v_add(D,t1,t1,F);
+        v_add(E,A,A,F);
+        v_add(E,E,A,F);
+        v_sqr(X3,E,F);
+        v_add(t2,D,D,F);
+        v_sub(X3,X3,t2,F);
+        v_sub(t1,D,X3,F);
+        v_mul(Y3,E,t1,F);
+        v_add(t3,C,C,F);
+        v_add(t3,t3,t3,F);
+        v_add(t3,t3,t3,F);
+        v_sub(Y3,Y3,t3,F);
+        v_mul(Z3,a.Y,a.Z,F);
+        v_add(Z3,Z3,Z3,F);
+    }
+    r.X = X3;
+    r.Y = Y3;
+    r.Z = Z3;
+}
+
+// R += b (madd-2007-bl) o cac lan co bit trong add. Lan R vo cuc nhan thang b;
+// lan gap R = +-b (H = 0) bi danh dau trong fail de tinh lai bang ban vo huong.
+SIMD256_TARGET static void v_madd(vjpoint& R,const vapoint& b,__mmask8 add,__mmask8& inf,__mmask8& fail,
+                                  const vfield& F)
+{
+    vfe Z1Z1,U2,S2,H,HH,I,J,r,V,t,X3,Y3,Z3;
+    v_sqr(Z1Z1,R.Z,F);
+    v_mul(U2,b.x,Z1Z1,F);
+    v_mul(t,R.Z,Z1Z1,F);
+    v_mul(S2,b.y,t,F);
+    v_sub(H,U2,R.X,F);
+    v_sub(r,S2,R.Y,F);
+    __mmask8 use = add & ~inf;
+    fail |= use & v_is_zero(H);
+    v_add(r,r,r,F);
+    v_sqr(HH,H,F);
+    v_add(I,HH,HH,F);
+    v_add(I,I,I,F);
+    v_mul(J,H,I,F);
+    v_mul(V,R.X,I,F);
+
+    v_sqr(X3,r,F);
+    v_sub(X3,X3,J,F);
+    v_sub(X3,X3,V,F);
+    v_sub(X3,X3,V,F);
+    v_sub(t,V,X3,F);
+    v_mul(Y3,r,t,F);
+    v_mul(t,R.Y,J,F);
+    v_add(t,t,t,F);
+    v_sub(Y3,Y3,t,F);
+    v_add(t,R.Z,H,F);
+    v_sqr(t,t,F);
+    v_sub(t,t,Z1Z1,F);
+    v_sub(Z3,t,HH,F);
+
+    __mmask8 fresh = add & inf;
+    vfe one;
+    v_const(one,F.one);
+    v_select(R.X,use,X3);
+    v_select(R.Y,use,Y3);
+    v_select(R.Z,use,Z3);
+    v_select(R.X,fresh,b.x);
+    v_select(R.Y,fresh,b.y);
+    v_select(R.Z,fresh,one);
+    inf &= ~add;
+}
+
+// r[i] = limb i cua 8 diem trong bang (limb i cua diem j o tab[i*stride + idx])
+SIMD256_TARGET static inline void v_gather(vfe& r,const limb_t* tab,v8 idx,int stride)
+{
+    for(int i = 0; i < 5; i++)
+        r.l[i] = v_gather64(idx,(const void*)(tab + i*stride));
+}
+
+// Nap 8 phan tu thuong lien tiep cua lo dang cot (A[q*stride + lan]) vao dang
+// Montgomery 5 x 52 bit; lan ngoai mask lay gia tri pad
+SIMD256_TARGET static void v_load(vfe& r,const limb_t* A,long stride,__mmask8 mask,const limb_t* pad,const vfield& F)
+{
+    v8 a[4];
+    for(int q = 0; q < 4; q++) a[q] = _mm512_mask_loadu_epi64(v_set(pad[q]),mask,(const void*)(A + q*stride));
+    vfe x,r2;
+    x.l[0] = _mm512_and_si512(a[0],F.mask);
+    x.l[1] = _mm512_and_si512(_mm512_or_si512(v_srli(a[0],52),v_slli(a[1],12)),F.mask);
+    x.l[2] = _mm512_and_si512(_mm512_or_si512(v_srli(a[1],40),v_slli(a[2],24)),F.mask);
+    x.l[3] = _mm512_and_si512(_mm512_or_si512(v_srli(a[2],28),v_slli(a[3],36)),F.mask);
+    x.l[4] = v_srli(a[3],16);
+    v_const(r2,F.r2);
+    v_mul(r,x,r2,F);
+}
+
+// Ghi 8 phan tu (ra khoi dang Montgomery) vao cac lan co bit trong mask
+SIMD256_TARGET static void v_store(limb_t* A,long stride,__mmask8 mask,const vfe& a,const vfield& F)
+{
+    vfe x,raw1;
+    v_const(raw1,F.raw1);
+    v_mul(x,a,raw1,F);
+    v8 r[4];
+    r[0] = _mm512_or_si512(x.l[0],v_slli(x.l[1],52));
+    r[1] = _mm512_or_si512(v_srli(x.l[1],12),v_slli(x.l[2],40));
+    r[2] = _mm512_or_si512(v_srli(x.l[2],24),v_slli(x.l[3],28));
+    r[3] = _mm512_or_si512(v_srli(x.l[3],36),v_slli(x.l[4],16));
+    for(int q = 0; q < 4; q++) _mm512_mask_storeu_epi64((void*)(A + q*stride),mask,r[q]);
+}
+
+template<class P>
+static gtab make_gtab()
+{
+    typedef Curve<P> C;
+    gtab G;
+    memset(&G,0,sizeof(G));
+    ZZ p,x;
+    limbs_to_ZZ(p,P::p);
+    ZZ R = power2_ZZ(260) % p;
+    const typename C::g_tables& g = C::g();
+    for(int j = 0; j < 15; j++)
+    {
+        const curve256_apoint* src[4] = {&g.win[j],&g.win[j],&g.comb[j],&g.comb[j]};
+        limb_t (*dst[4])[16] = {G.wx,G.wy,G.cx,G.cy};
+        for(int c = 0; c < 4; c++)
+        {
+            limb_t t[4],u[5];
+            C::from_mont(t,(c & 1) ? src[c]->y : src[c]->x);
+            limbs_to_ZZ(x,t);
+            ZZ_to_52(u,MulMod(x,R,p));
+            for(int i = 0; i < 5; i++) dst[c][i][j+1] = u[i];
+        }
+    }
+    return G;
+}
+
+template<class P>
+static const gtab& gtables()
+{
+    static const gtab G = make_gtab<P>();
+    return G;
+}
+
+static __mmask8 lane_mask(long count)
+{
+    return count >= 8 ? 0xff : (__mmask8)((1u << count) - 1);
+}
+
+// Dua R ve affine (mot nghich dao vector cho ca 8 lan) va ghi vao lo ket qua
+template<class P>
+SIMD256_TARGET static unsigned finish(const curve256_soa_view& out,const vjpoint& R,__mmask8 rinf,__mmask8 fail,
+                                      const vfield& F)
+{
+    vfe zi,zi2,t,ax,ay;
+    v_inv(zi,R.Z,F);
+    v_sqr(zi2,zi,F);
+    v_mul(ax,R.X,zi2,F);
+    v_mul(t,zi2,zi,F);
+    v_mul(ay,R.Y,t,F);
+    __mmask8 m = lane_mask(out.n);
+    v_store(out.X,out.stride,m,ax,F);
+    v_store(out.Y,out.stride,m,ay,F);
+    for(long l = 0; l < out.n; l++) out.inf[l] = (rinf >> l) & 1;
+    return ~(unsigned)fail & m;
+}
+
+// Nap lo so vo huong: kv[q] la limb q cua 8 so (lan thua = 0)
+SIMD256_TARGET static void load_scalars(v8* kv,const curve256_soa_view& k)
+{
+    __mmask8 m = lane_mask(k.n);
+    for(int q = 0; q < 4; q++) kv[q] = _mm512_maskz_loadu_epi64(m,(const void*)(k.X + q*k.stride));
+}
+
+// Chu so 4 bit thu j cua 8 so
+SIMD256_TARGET static inline v8 nibble(const v8* kv,int j)
+{
+    v8 s = v_srlv(kv[j/16],v_set(4*(j%16)));
+    return _mm512_and_si512(s,v_set(15));
+}
+
+// Comb 4 x 64 bit nhu Curve<P>::mul_g, 8 lan cung luc
+template<class P>
+SIMD256_TARGET static unsigned mul_g_lanes(const curve256_soa_view& out,const curve256_soa_view& k)
+{
+    const vfield& F = field<P>();
+    const gtab& G = gtables<P>();
+    v8 kv[4];
+    load_scalars(kv,k);
+
+    vjpoint R;
+    v_const(R.X,F.one);
+    v_const(R.Y,F.one);
+    v_const(R.Z,F.one);
+    __mmask8 rinf = 0xff,fail = 0;
+    const v8 one = v_set(1);
+    for(int col = 63; col >= 0; col--)
+    {
+        v_dbl<P>(R,R,F);
+        v8 c = v_set(col);
+        v8 j = _mm512_setzero_si512();
+        for(int i = 0; i < 4; i++)
+        {
+            v8 b = _mm512_and_si512(v_srlv(kv[i],c),one);
+            j = _mm512_or_si512(j,v_sllv(b,v_set(i)));
+        }
+        __mmask8 add = _mm512_test_epi64_mask(j,j);
+        if(!add) continue;
+        vapoint B;
+        v_gather(B.x,&G.cx[0][0],j,16);
+        v_gather(B.y,&G.cy[0][0],j,16);
+        v_madd(R,B,add,rinf,fail,F);
+    }
+    return finish<P>(out,R,rinf,fail,F);
+}
+
+// Straus: bang cua so chung cua G va bang rieng cua Q tung lan, chung phep nhan doi
+template<class P>
+SIMD256_TARGET static unsigned mul_gq_lanes(const curve256_soa_view& out,const curve256_soa_view& k1,
+                                            const curve256_soa_view& k2,const curve256_soa_view& q)
+{
+    const vfield& F = field<P>();
+    const gtab& G = gtables<P>();
+    v8 kv1[4],kv2[4];
+    load_scalars(kv1,k1);
+    load_scalars(kv2,k2);
+
+    // lan thua dung Q = G, he so 0
+    vapoint Q;
+    v_load(Q.x,q.X,q.stride,lane_mask(q.n),P::gx,F);
+    v_load(Q.y,q.Y,q.stride,lane_mask(q.n),P::gy,F);
+
+    // T[j-1] = jQ dang Jacobian, roi ve affine voi mot nghich dao (Montgomery)
+    vjpoint T[15];
+    __mmask8 fail = 0,none = 0;
+    T[0].X = Q.x;
+    T[0].Y = Q.y;
+    v_const(T[0].Z,F.one);
+    v_dbl<P>(T[1],T[0],F);
+    for(int j = 2; j < 15; j++)
+    {
+        T[j] = T[j-1];
+        v_madd(T[j],Q,0xff,none,fail,F);
+    }
+    vfe pre[15],acc,zi,zi2,t,ax,ay;
+    pre[0] = T[0].Z;
+    for(int j = 1; j < 15; j++) v_mul(pre[j],pre[j-1],T[j].Z,F);
+    v_inv(acc,pre[14],F);
+    // qtab[i][d*8 + lan]: limb i cua dQ o lan do
+    limb_t tx[5][128],ty[5][128];
+    for(int i = 0; i < 5; i++)
+    {
+        _mm512_storeu_si512((void*)tx[i],_mm512_setzero_si512());
+        _mm512_storeu_si512((void*)ty[i],_mm512_setzero_si512());
+    }
+    for(int j = 14; j >= 0; j--)
+    {
+        if(j > 0)
+        {
+            v_mul(zi,acc,pre[j-1],F);
+            v_mul(acc,acc,T[j].Z,F);
+        }
+        else zi = acc;
+        v_sqr(zi2,zi,F);
+        v_mul(ax,T[j].X,zi2,F);
+        v_mul(t,zi2,zi,F);
+        v_mul(ay,T[j].Y,t,F);
+        for(int i = 0; i < 5; i++)
+        {
+            _mm512_storeu_si512((void*)(tx[i] + 8*(j+1)),ax.l[i]);
+            _mm512_storeu_si512((void*)(ty[i] + 8*(j+1)),ay.l[i]);
+        }
+    }
+
+    vjpoint R;
+    v_const(R.X,F.one);
+    v_const(R.Y,F.one);
+    v_const(R.Z,F.one);
+    __mmask8 rinf = 0xff;
+    const v8 lane = _mm512_set_epi64(7,6,5,4,3,2,1,0);
+    for(int j = 63; j >= 0; j--)
+    {
+        for(int s = 0; s < 4; s++) v_dbl<P>(R,R,F);
+        vapoint B;
+        v8 d = nibble(kv1,j);
+        __mmask8 add = _mm512_test_epi64_mask(d,d);
+        if(add)
+        {
+            v_gather(B.x,&G.wx[0][0],d,16);
+            v_gather(B.y,&G.wy[0][0],d,16);
+            v_madd(R,B,add,rinf,fail,F);
+        }
+        d = nibble(kv2,j);
+        add = _mm512_test_epi64_mask(d,d);
+        if(add)
+        {
+            v8 idx = _mm512_add_epi64(v_slli(d,3),lane);
+            v_gather(B.x,&tx[0][0],idx,128);
+            v_gather(B.y,&ty[0][0],idx,128);
+            v_madd(R,B,add,rinf,fail,F);
+        }
+    }
+    return finish<P>(out,R,rinf,fail,F);
+}
+
+// thuoc tinh target khong di theo khai bao trong simd256.h nen than ham nam o
+// ham static ben tren
+template<class P>
+unsigned simd256_mul_g(const curve256_soa_view& R,const curve256_soa_view& k)
+{
+    return mul_g_lanes<P>(R,k);
+}
+
+template<class P>
+unsigned simd256_mul_gq(const curve256_soa_view& R,const curve256_soa_view& k1,const curve256_soa_view& k2,
+                        const curve256_soa_view& Q)
+{
+    return mul_gq_lanes<P>(R,k1,k2,Q);
+}
+
+template unsigned simd256_mul_g<P256Params>(const curve256_soa_view&,const curve256_soa_view&);
+template unsigned simd256_mul_g<K256Params>(const curve256_soa_view&,const curve256_soa_view&);
+template unsigned simd256_mul_gq<P256Params>(const curve256_soa_view&,const curve256_soa_view&,const curve256_soa_view&,
+                                             const curve256_soa_view&);
+template unsigned simd256_mul_gq<K256Params>(const curve256_soa_view&,const curve256_soa_view&,const curve256_soa_view&,
+                                             const curve256_soa_view&);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef SIMD256_H
+#define SIMD256_H
+
+#include "curve256.h"
+
+// Phep tinh 8 lan song song (AVX-512 IFMA) cho P-256 / secp256k1: moi phan tu
+// truong gom 5 limb 52 bit, limb i cua 8 phan tu nam chung mot thanh ghi zmm,
+// dang Montgomery R = 2^260; vpmadd52luq/huq cho tich 52 x 52 bit cua ca 8 lan
+// trong mot lenh. Dung cho lo nhieu phep nhan vo huong doc lap (tao khoa, xac
+// thuc hang loat) va chi duoc goi khi cpu_features() >= CPU_AVX512_IFMA.
+
+#if defined(CURVE256_FAST) && defined(CURVE256_ADX)
+#define SIMD256 1
+#define SIMD256_LANES 8
+
+// Lo dang cot (curve256_soa_view), toa do vao/ra dang thuong (khong Montgomery);
+// so vo huong < n. R.n <= SIMD256_LANES; limb q cua 8 phan tu nam lien nhau nen
+// doc/ghi thang vao thanh ghi. Tra ve mat na cac phan tu da tinh xong: phan tu gap
+// truong hop dac biet cua cong thuc cong (R = +-B) co bit 0 va phai tinh lai bang
+// ban vo huong.
+
+// R[i] = k[i]*G
+template<class P>
+unsigned simd256_mul_g(const curve256_soa_view& R,const curve256_soa_view& k);
+// R[i] = k1[i]*G + k2[i]*Q[i], Q[i] khong la diem vo cuc
+template<class P>
+unsigned simd256_mul_gq(const curve256_soa_view& R,const curve256_soa_view& k1,const curve256_soa_view& k2,
+                        const curve256_soa_view& Q);
+
+#endif
+
+#endif